@@ -0,0 +1,401 @@
+// Benchmarks for vec.h against std::vector and the standard algorithms.
+//
+//   make -C bench run                  # table on stdout
+//   ./bench/bench --format=csv         # or json, for regression tracking
+//   ./bench/bench --filter=sort --quick
+//
+// Results are keyed by the name and the element count `n`, `ns_per_op` is the
+// time of the fastest run divided by `n`. `--quick` divides the bigger counts
+// by 10.
+//
+// Every case runs in its own process, so the peak RSS of one case doesn't
+// hide the next one. Both sides count every call that asks the allocator for
+// memory: vec.h through VEC_MALLOC and VEC_REALLOC, including its scratch
+// buffers, and the standard library through the replaced operator new.
+
+#include <cstdint>
+#include <cstdlib>
+
+static uint64_t vec_alloc_calls;
+
+#define VEC_MALLOC(size) (vec_alloc_calls++, malloc(size))
+#define VEC_REALLOC(ptr, size) (vec_alloc_calls++, realloc(ptr, size))
+#include "../vec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+typedef struct {
+    int64_t key;
+    int64_t payload[7];
+} wide;
+
+vec_define_primitive(int32_t, "%d");
+vec_define_primitive(int64_t, "%" PRId64);
+vec_define(wide, wides);
+vec_define_free_simple(wide, wides);
+vec_define_sort(wide, wides, (a.key > b.key) - (a.key < b.key));
+
+static uint64_t std_allocs;
+
+void *operator new(size_t size) {
+    std_allocs++;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    std_allocs++;
+    return malloc(size ? size : 1);
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// Keeps the compiler from dropping the work of a benchmark.
+static volatile uint64_t sink;
+
+struct result {
+    double ns_per_op;
+    uint64_t allocs;
+};
+
+struct bench_case {
+    std::string name;
+    size_t n;
+    // Runs the case once with `n` elements.
+    std::function<void(size_t n)> run;
+    // Reads the allocation counter of the library being measured.
+    std::function<uint64_t()> allocs;
+};
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rng() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static uint64_t vec_allocs() { return vec_alloc_calls; }
+
+static uint64_t std_allocs_now() { return std_allocs; }
+
+static double now_ns() {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+template <typename T> static T make(size_t i) { return (T)i; }
+template <> wide make<wide>(size_t i) {
+    wide w;
+    w.key = (int64_t)i;
+    for (int j = 0; j < 7; j++)
+        w.payload[j] = (int64_t)i + j;
+    return w;
+}
+
+template <typename V, typename T>
+static void add_push(std::vector<bench_case> &cases, const char *type,
+                     void (*init)(V *), void (*init_reserved)(V *, size_t),
+                     void (*push)(V *, T), void (*clear)(V *)) {
+    static const size_t sizes[] = {1000, 100000, 10000000};
+    for (size_t n : sizes) {
+        std::string suffix = std::string("/") + type;
+        cases.push_back({"push/vec" + suffix, n,
+                         [=](size_t n) {
+                             V v;
+                             init(&v);
+                             for (size_t i = 0; i < n; i++)
+                                 push(&v, make<T>(i));
+                             sink += v.size;
+                             clear(&v);
+                         },
+                         vec_allocs});
+        cases.push_back({"push_reserved/vec" + suffix, n,
+                         [=](size_t n) {
+                             V v;
+                             init_reserved(&v, n);
+                             for (size_t i = 0; i < n; i++)
+                                 push(&v, make<T>(i));
+                             sink += v.size;
+                             clear(&v);
+                         },
+                         vec_allocs});
+        cases.push_back({"push/std" + suffix, n,
+                         [](size_t n) {
+                             std::vector<T> v;
+                             for (size_t i = 0; i < n; i++)
+                                 v.push_back(make<T>(i));
+                             sink += v.size();
+                         },
+                         std_allocs_now});
+        cases.push_back({"push_reserved/std" + suffix, n,
+                         [](size_t n) {
+                             std::vector<T> v;
+                             v.reserve(n);
+                             for (size_t i = 0; i < n; i++)
+                                 v.push_back(make<T>(i));
+                             sink += v.size();
+                         },
+                         std_allocs_now});
+    }
+}
+
+// The input of the cases below is prepared outside of the timed part.
+static int32_ts input;
+static std::vector<int32_t> std_input;
+static wides wide_input;
+static std::vector<wide> std_wide_input;
+
+static void prepare(size_t n) {
+    int32_ts_init_reserved(&input, n);
+    std_input.clear();
+    wides_init_reserved(&wide_input, n);
+    std_wide_input.clear();
+    for (size_t i = 0; i < n; i++) {
+        int32_t x = (int32_t)rng();
+        int32_ts_push(&input, x);
+        std_input.push_back(x);
+        wides_push(&wide_input, make<wide>((size_t)rng()));
+    }
+    std_wide_input.assign(wide_input.data, wide_input.data + n);
+}
+
+static void add_algorithms(std::vector<bench_case> &cases) {
+    const size_t n = 1000000;
+    cases.push_back({"sort/vec/int32", n,
+                     [](size_t) {
+                         int32_ts v;
+                         int32_ts_init_reserved(&v, input.size);
+                         int32_ts_append_n(&v, input.data, input.size);
+                         int32_ts_sort(&v);
+                         sink += (uint64_t)v.data[0];
+                         int32_ts_clear(&v);
+                     },
+                     vec_allocs});
+    cases.push_back({"sort_reversed/vec/int32", n,
+                     [](size_t) {
+                         int32_ts v;
+                         int32_ts_init_reserved(&v, input.size);
+                         int32_ts_append_n(&v, input.data, input.size);
+                         int32_ts_sort_reversed(&v);
+                         sink += (uint64_t)v.data[0];
+                         int32_ts_clear(&v);
+                     },
+                     vec_allocs});
+    cases.push_back({"sort/std/int32", n,
+                     [](size_t) {
+                         std::vector<int32_t> v(std_input);
+                         std::sort(v.begin(), v.end());
+                         sink += (uint64_t)v[0];
+                     },
+                     std_allocs_now});
+    cases.push_back({"sort_reversed/std/int32", n,
+                     [](size_t) {
+                         std::vector<int32_t> v(std_input);
+                         std::sort(v.begin(), v.end(), std::greater<int32_t>());
+                         sink += (uint64_t)v[0];
+                     },
+                     std_allocs_now});
+    cases.push_back({"sort/vec/wide", n,
+                     [](size_t) {
+                         wides v;
+                         wides_init_reserved(&v, wide_input.size);
+                         wides_append_n(&v, wide_input.data, wide_input.size);
+                         wides_sort(&v);
+                         sink += (uint64_t)v.data[0].key;
+                         wides_clear(&v);
+                     },
+                     vec_allocs});
+    cases.push_back({"sort/std/wide", n,
+                     [](size_t) {
+                         std::vector<wide> v(std_wide_input);
+                         std::sort(v.begin(), v.end(),
+                                   [](const wide &a, const wide &b) {
+                                       return a.key < b.key;
+                                   });
+                         sink += (uint64_t)v[0].key;
+                     },
+                     std_allocs_now});
+    // Searches for a missing element, so the whole vector is scanned.
+    cases.push_back({"contains/vec/int32", n,
+                     [](size_t) {
+                         sink += int32_ts_contains(input, INT32_MIN + 1);
+                     },
+                     vec_allocs});
+    cases.push_back({"contains/std/int32", n,
+                     [](size_t) {
+                         sink += std::find(std_input.begin(), std_input.end(),
+                                           INT32_MIN + 1) != std_input.end();
+                     },
+                     std_allocs_now});
+    cases.push_back({"reverse/vec/int32", n,
+                     [](size_t) {
+                         int32_ts_reverse(&input);
+                         sink += (uint64_t)input.data[0];
+                     },
+                     vec_allocs});
+    cases.push_back({"reverse/std/int32", n,
+                     [](size_t) {
+                         std::reverse(std_input.begin(), std_input.end());
+                         sink += (uint64_t)std_input[0];
+                     },
+                     std_allocs_now});
+    cases.push_back({"resize/vec/int32", n,
+                     [](size_t n) {
+                         int32_ts v;
+                         int32_ts_init(&v);
+                         for (size_t m = 16; m <= n; m *= 2)
+                             int32_ts_resize(&v, m, 1);
+                         sink += v.size;
+                         int32_ts_clear(&v);
+                     },
+                     vec_allocs});
+    cases.push_back({"resize/std/int32", n,
+                     [](size_t n) {
+                         std::vector<int32_t> v;
+                         for (size_t m = 16; m <= n; m *= 2)
+                             v.resize(m, 1);
+                         sink += v.size();
+                     },
+                     std_allocs_now});
+}
+
+struct options {
+    const char *format = "table";
+    const char *filter = "";
+    bool quick = false;
+    int repeat = 5;
+};
+
+static bool fixed_input(const std::string &name) {
+    return name.rfind("push", 0) != 0 && name.rfind("resize", 0) != 0;
+}
+
+// Runs a case `repeat` times after a warm up and keeps the fastest run.
+static result measure(const bench_case &c, size_t n, int repeat) {
+    if (fixed_input(c.name))
+        prepare(n);
+    c.run(n);
+    result best = {0, 0};
+    for (int r = 0; r < repeat; r++) {
+        uint64_t allocs = c.allocs();
+        double start = now_ns();
+        c.run(n);
+        double ns = (now_ns() - start) / (double)n;
+        if (r == 0 || ns < best.ns_per_op)
+            best.ns_per_op = ns;
+        best.allocs = c.allocs() - allocs;
+    }
+    return best;
+}
+
+static void print_header(const options &o) {
+    if (!strcmp(o.format, "csv"))
+        printf("name,n,ns_per_op,allocs,peak_rss_kb\n");
+    else if (!strcmp(o.format, "json"))
+        printf("[");
+    else
+        printf("%-32s %10s %12s %8s %12s\n", "name", "n", "ns/op", "allocs",
+               "peak rss kb");
+}
+
+static void print_result(const options &o, const bench_case &c, size_t n,
+                         result r, long rss, bool first) {
+    if (!strcmp(o.format, "csv"))
+        printf("%s,%zu,%.3f,%llu,%ld\n", c.name.c_str(), n, r.ns_per_op,
+               (unsigned long long)r.allocs, rss);
+    else if (!strcmp(o.format, "json"))
+        printf("%s\n  {\"name\": \"%s\", \"n\": %zu, \"ns_per_op\": %.3f, "
+               "\"allocs\": %llu, \"peak_rss_kb\": %ld}",
+               first ? "" : ",", c.name.c_str(), n, r.ns_per_op,
+               (unsigned long long)r.allocs, rss);
+    else
+        printf("%-32s %10zu %12.3f %8llu %12ld\n", c.name.c_str(), n,
+               r.ns_per_op, (unsigned long long)r.allocs, rss);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    options o;
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "--format=", 9))
+            o.format = argv[i] + 9;
+        else if (!strncmp(argv[i], "--filter=", 9))
+            o.filter = argv[i] + 9;
+        else if (!strncmp(argv[i], "--repeat=", 9))
+            o.repeat = atoi(argv[i] + 9) > 0 ? atoi(argv[i] + 9) : 1;
+        else if (!strcmp(argv[i], "--quick"))
+            o.quick = true;
+        else {
+            fprintf(stderr,
+                    "usage: %s [--format=table|csv|json] [--filter=text] "
+                    "[--repeat=n] [--quick]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<bench_case> cases;
+    add_push<int32_ts, int32_t>(cases, "int32", int32_ts_init,
+                                int32_ts_init_reserved, int32_ts_push,
+                                int32_ts_clear);
+    add_push<int64_ts, int64_t>(cases, "int64", int64_ts_init,
+                                int64_ts_init_reserved, int64_ts_push,
+                                int64_ts_clear);
+    add_push<wides, wide>(cases, "wide", wides_init, wides_init_reserved,
+                          wides_push, wides_clear);
+    add_algorithms(cases);
+
+    print_header(o);
+    bool first = true;
+    for (const bench_case &c : cases) {
+        if (!strstr(c.name.c_str(), o.filter))
+            continue;
+        size_t n = o.quick && c.n > 1000 ? c.n / 10 : c.n;
+        int fds[2];
+        if (pipe(fds) < 0) {
+            perror("pipe failed");
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork failed");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            result r = measure(c, n, o.repeat);
+            ssize_t written = write(fds[1], &r, sizeof(r));
+            _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+        }
+        close(fds[1]);
+        result r;
+        ssize_t got = read(fds[0], &r, sizeof(r));
+        close(fds[0]);
+        int status;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) < 0 || got != (ssize_t)sizeof(r) ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "%s failed\n", c.name.c_str());
+            return 1;
+        }
+        print_result(o, c, n, r, usage.ru_maxrss, first);
+        first = false;
+    }
+    if (!strcmp(o.format, "json"))
+        printf("\n]\n");
+    return 0;
+}
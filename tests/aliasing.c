@@ -0,0 +1,51 @@
+#include "../vec.h"
+#include "check.h"
+
+vec_define(int, ints);
+vec_define_free_simple(int, ints);
+
+// A vector of 0..n-1 with no spare capacity, so the next insertion moves it.
+static ints range(int n) {
+    ints v;
+    ints_init_reserved(&v, 0);
+    for (int i = 0; i < n; i++)
+        ints_push(&v, i);
+    ints_shrink(&v);
+    return v;
+}
+
+int main(void) {
+    // append_n from its own buffer while it grows.
+    ints v = range(8);
+    ints_append_n(&v, v.data + 2, 5);
+    CHECK(v.size == 13);
+    for (int i = 0; i < 5; i++)
+        CHECK(v.data[8 + i] == 2 + i);
+    ints_clear(&v);
+
+    v = range(8);
+    ints_extend(&v, v);
+    for (int i = 0; i < 16; i++)
+        CHECK(v.data[i] == i % 8);
+    ints_clear(&v);
+
+    // insert_n with every source range and insertion point, including
+    // sources that straddle the insertion point.
+    for (size_t i = 0; i <= 8; i++) {
+        for (size_t at = 0; at < 8; at++) {
+            for (size_t n = 1; at + n <= 8; n++) {
+                v = range(8);
+                ints_insert_n(&v, i, v.data + at, n);
+                CHECK(v.size == 8 + n);
+                for (size_t j = 0; j < v.size; j++) {
+                    int expected = j < i       ? (int)j
+                                   : j < i + n ? (int)(at + j - i)
+                                               : (int)(j - n);
+                    CHECK(v.data[j] == expected);
+                }
+                ints_clear(&v);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <sys/wait.h>
+
+vec_define_bits(bits);
+
+#define MAX 1100
+
+// Reference bits the vector is compared against.
+static bool model[MAX];
+static size_t model_size;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Every bit, `count` and the `find_first_set`/`find_next_set` walk must agree
+// with the model, and the bits past `size` must be clear.
+static void check_model(bits v) {
+    CHECK(v.size == model_size && v.capacity >= v.size);
+    size_t count = 0;
+    for (size_t i = 0; i < v.size; i++) {
+        CHECK(bits_at(v, i) == model[i]);
+        count += model[i];
+    }
+    CHECK(bits_count(v) == count);
+    for (size_t i = v.size; i < v.capacity; i++)
+        CHECK(!(v.data[i / 64] & _VCBITS_MASK(i)));
+
+    size_t i = bits_find_first_set(v);
+    for (size_t j = 0; j < v.size; j++) {
+        if (!model[j])
+            continue;
+        CHECK(i == j);
+        i = bits_find_next_set(v, i);
+    }
+    CHECK(i == VEC_NPOS);
+}
+
+static void resize(bits *v, size_t n, bool x) {
+    bits_resize(v, n, x);
+    for (size_t i = model_size; i < n; i++)
+        model[i] = x;
+    model_size = n;
+    check_model(*v);
+}
+
+static void fill_random(bits *v, size_t n) {
+    bits_clear(v);
+    model_size = 0;
+    for (size_t i = 0; i < n; i++) {
+        model[i] = rng() & 1;
+        bits_push(v, model[i]);
+    }
+    model_size = n;
+    check_model(*v);
+}
+
+// Runs a word operation on vectors of different sizes in a child process,
+// which must exit with the size error.
+static void check_size_error(void (*op)(bits *, bits), size_t a, size_t b) {
+    fflush(stderr);
+    int pipes[2];
+    CHECK(pipe(pipes) == 0);
+    pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        dup2(pipes[1], STDERR_FILENO);
+        bits x, y;
+        bits_init(&x);
+        bits_init(&y);
+        bits_resize(&x, a, true);
+        bits_resize(&y, b, true);
+        op(&x, y);
+        _exit(0);
+    }
+    close(pipes[1]);
+    char msg[256] = {0};
+    size_t got = 0;
+    ssize_t n;
+    while ((n = read(pipes[0], msg + got, sizeof(msg) - 1 - got)) > 0)
+        got += (size_t)n;
+    close(pipes[0]);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE);
+    CHECK(strstr(msg, "vector sizes differ"));
+}
+
+int main(void) {
+    bits v;
+    bits_init(&v);
+    check_model(v);
+
+    // Growing with true, shrinking and growing with false across word
+    // boundaries must not bring back the bits that were cut off.
+    resize(&v, 70, true);
+    resize(&v, 200, true);
+    resize(&v, 63, false);
+    resize(&v, 130, false);
+    resize(&v, 129, true);
+    resize(&v, 64, true);
+    resize(&v, 300, false);
+    resize(&v, 1, true);
+    resize(&v, 128, false);
+    resize(&v, 0, false);
+    resize(&v, 500, true);
+    bits_shrink(&v);
+    resize(&v, 10, true);
+    bits_shrink(&v);
+    resize(&v, 200, false);
+    for (int round = 0; round < 200; round++) {
+        size_t n = rng() % 1024;
+        resize(&v, n, rng() & 1);
+    }
+
+    // find_next_set across the word boundary at bits 63 and 64.
+    bits_clear(&v);
+    model_size = 0;
+    resize(&v, 200, false);
+    bits_set(&v, 63, true);
+    bits_set(&v, 64, true);
+    bits_set(&v, 127, true);
+    bits_set(&v, 128, true);
+    bits_set(&v, 199, true);
+    model[63] = model[64] = model[127] = model[128] = model[199] = true;
+    check_model(v);
+    CHECK(bits_find_first_set(v) == 63);
+    CHECK(bits_find_next_set(v, 62) == 63);
+    CHECK(bits_find_next_set(v, 63) == 64);
+    CHECK(bits_find_next_set(v, 64) == 127);
+    CHECK(bits_find_next_set(v, 128) == 199);
+    CHECK(bits_find_next_set(v, 199) == VEC_NPOS);
+    bits_set(&v, 64, false);
+    CHECK(bits_find_next_set(v, 63) == 127);
+    resize(&v, 64, false);
+    CHECK(bits_find_next_set(v, 62) == 63);
+    CHECK(bits_find_next_set(v, 63) == VEC_NPOS);
+    resize(&v, 65, true);
+    CHECK(bits_find_next_set(v, 63) == 64);
+    CHECK(bits_find_next_set(v, 64) == VEC_NPOS);
+
+    // `not` keeps the bits past size clear, so `count` only sees real bits.
+    size_t sizes[] = {0, 1, 63, 64, 65, 127, 128, 129, 1000};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        fill_random(&v, sizes[k]);
+        size_t before = bits_count(v);
+        bits_not(&v);
+        for (size_t i = 0; i < model_size; i++)
+            model[i] = !model[i];
+        check_model(v);
+        CHECK(bits_count(v) == sizes[k] - before);
+        resize(&v, sizes[k] + 70, false);
+    }
+
+    // and, or and xor against a reference, then on different sizes.
+    bits w;
+    bits_init(&w);
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t n = sizes[k];
+        bool other[MAX];
+        fill_random(&w, n);
+        memcpy(other, model, sizeof(bool) * n);
+        for (int op = 0; op < 3; op++) {
+            fill_random(&v, n);
+            if (op == 0)
+                bits_and(&v, w);
+            else if (op == 1)
+                bits_or(&v, w);
+            else
+                bits_xor(&v, w);
+            for (size_t i = 0; i < n; i++)
+                model[i] = op == 0   ? model[i] && other[i]
+                           : op == 1 ? model[i] || other[i]
+                                     : model[i] != other[i];
+            check_model(v);
+        }
+    }
+    check_size_error(bits_and, 64, 65);
+    check_size_error(bits_or, 100, 10);
+    check_size_error(bits_xor, 0, 1);
+
+    bits_clear(&v);
+    bits_clear(&w);
+    return 0;
+}
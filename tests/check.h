@@ -0,0 +1,17 @@
+#ifndef VEC_TESTS_CHECK_H
+#define VEC_TESTS_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Like assert, but also checked with NDEBUG.
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+    } while (0)
+
+#endif // VEC_TESTS_CHECK_H
@@ -0,0 +1,59 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <pthread.h>
+
+vec_define(size_t, sizes);
+vec_define_free_simple(size_t, sizes);
+vec_define_concurrent(size_t, csizes, sizes);
+
+#define THREADS 8
+#define PUSHES 100000
+
+static csizes shared;
+
+// Every thread pushes `thread + THREADS * i`, so each value shows up once.
+static void *producer(void *arg) {
+    size_t thread = (size_t)arg;
+    for (size_t i = 0; i < PUSHES; i++)
+        csizes_push(&shared, thread + THREADS * i);
+    return NULL;
+}
+
+int main(void) {
+    csizes_init(&shared);
+    pthread_t threads[THREADS];
+    for (size_t t = 0; t < THREADS; t++)
+        CHECK(pthread_create(&threads[t], NULL, producer, (void *)t) == 0);
+    for (size_t t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+    CHECK(shared.size == THREADS * PUSHES);
+
+    sizes flat;
+    sizes_init(&flat);
+    csizes_flatten(&shared, &flat);
+    CHECK(flat.size == THREADS * PUSHES);
+    bool *seen = (bool *)calloc(flat.size, sizeof(bool));
+    CHECK(seen);
+    for (size_t i = 0; i < flat.size; i++) {
+        CHECK(flat.data[i] < flat.size && !seen[flat.data[i]]);
+        seen[flat.data[i]] = true;
+        CHECK(csizes_at(&shared, i) == flat.data[i]);
+    }
+    free(seen);
+
+    // Elements pushed by one thread keep their order.
+    size_t next[THREADS] = {0};
+    for (size_t i = 0; i < flat.size; i++) {
+        size_t thread = flat.data[i] % THREADS;
+        CHECK(flat.data[i] / THREADS == next[thread]);
+        next[thread]++;
+    }
+
+    size_t first = csizes_claim(&shared, 1000);
+    CHECK(first == THREADS * PUSHES && shared.size == first + 1000);
+    csizes_clear(&shared);
+    CHECK(shared.size == 0);
+    sizes_clear(&flat);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "../vec.h"
+#include "check.h"
+
+// `live` counts the strings not freed yet. The clearing threads update it
+// too, so it's atomic.
+typedef char *str;
+static size_t live;
+
+static str make(int i) {
+    str s = (str)malloc(16);
+    CHECK(s);
+    snprintf(s, 16, "%d", i);
+    __atomic_add_fetch(&live, 1, __ATOMIC_RELAXED);
+    return s;
+}
+
+static void release(str s) {
+    __atomic_sub_fetch(&live, 1, __ATOMIC_RELAXED);
+    free(s);
+}
+
+static size_t alive(void) { return __atomic_load_n(&live, __ATOMIC_RELAXED); }
+
+vec_define(str, strs);
+vec_define_free(str, strs, release(a));
+vec_define_shared(str, shared_strs);
+vec_define_free(str, shared_strs, release(a));
+vec_define_alloc(str, arena_strs);
+vec_define_free(str, arena_strs, release(a));
+
+#define BIG (VEC_DEFERRED_THRESHOLD * 20)
+
+int main(void) {
+    // The buffer leaves right away and is freed by another thread.
+    strs v;
+    strs_init(&v);
+    for (int round = 0; round < 8; round++) {
+        for (int i = 0; i < BIG; i++)
+            strs_push(&v, make(i));
+        strs_clear_deferred(&v);
+        CHECK(v.size == 0 && v.data == NULL);
+    }
+    for (int i = 0; i < 10; i++)
+        strs_push(&v, make(i));
+    strs_clear_deferred(&v); // below the threshold: cleared right here
+    vec_deferred_wait();
+    CHECK(alive() == 0);
+    vec_deferred_wait(); // nothing pending
+
+    // clear_step spreads the work over several calls.
+    for (int i = 0; i < 5000; i++)
+        strs_push(&v, make(i));
+    size_t steps = 1;
+    while (!strs_clear_step(&v, 1000))
+        steps++;
+    CHECK(steps == 5 && alive() == 0 && v.data == NULL);
+
+    // reset frees the elements and keeps the buffer.
+    strs_init(&v);
+    for (int i = 0; i < 100; i++)
+        strs_push(&v, make(i));
+    size_t capacity = v.capacity;
+    strs_reset(&v);
+    CHECK(v.size == 0 && v.capacity == capacity && alive() == 0);
+    strs_clear(&v);
+
+    // Views and clones only drop their reference, the last owner frees.
+    shared_strs s;
+    shared_strs_init(&s);
+    for (int i = 0; i < BIG; i++)
+        shared_strs_push(&s, make(i));
+    shared_strs view = shared_strs_slice(s, 0, BIG);
+    shared_strs clone = shared_strs_clone(&s);
+    shared_strs stepped = shared_strs_clone(&s);
+    shared_strs reset = shared_strs_clone(&s);
+    shared_strs_clear_deferred(&view);
+    shared_strs_clear_deferred(&clone);
+    CHECK(shared_strs_clear_step(&stepped, 1));
+    shared_strs_reset(&reset);
+    CHECK(reset.size == 0 && reset.data != s.data && *s.refs == 1);
+    vec_deferred_wait();
+    CHECK(alive() == BIG && atoi(s.data[BIG - 1]) == BIG - 1);
+    shared_strs_clear(&reset);
+    shared_strs_clear_deferred(&s);
+    vec_deferred_wait();
+    CHECK(alive() == 0);
+
+    // The arena isn't thread safe, so it's cleared on this thread.
+    vec_arena arena;
+    vec_arena_init(&arena, 1 << 16);
+    arena_strs a;
+    arena_strs_init_with(&a, &arena.allocator);
+    for (int i = 0; i < BIG; i++)
+        arena_strs_push(&a, make(i));
+    arena_strs_clear_deferred(&a);
+    CHECK(alive() == 0);
+    vec_arena_destroy(&arena);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <limits.h>
+
+vec_define_primitive(int, "%d");
+vec_define_print2(int, ints, old_ints, printf("%d", a), 1);
+vec_define_format2(int, ints, flat_ints,
+                   _VCBUF_PRIMITIVE(buf, int, "%d", a), 0);
+vec_define_print2(int, ints, old_flat_ints, printf("%d", a), 0);
+vec_define_format2(int, ints, wide_ints, vec_buf_printf(buf, "%5d", a), 1);
+vec_define_print2(int, ints, old_wide_ints, printf("%5d", a), 1);
+
+vec_define(ints, intss);
+vec_define_format(ints, intss, ints_format_indent(buf, a, indent));
+vec_define_print2(ints, intss, old_intss, old_ints_print_indent(a, indent), 1);
+vec_define_free(ints, intss, ints_clear(&a));
+
+static char path[] = "/tmp/vec_format_XXXXXX";
+
+static char *read_all(int fd) {
+    vec_buf b;
+    vec_buf_init(&b);
+    CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    ssize_t n;
+    while ((n = read(fd, vec_buf_reserve(&b, 4096), 4096)) > 0)
+        b.size += (size_t)n;
+    CHECK(n == 0);
+    *vec_buf_reserve(&b, 0) = '\0';
+    return b.data;
+}
+
+static int temp_file(void) {
+    strcpy(path, "/tmp/vec_format_XXXXXX");
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+// Runs `call` with stdout sent to a file and sets `out` to what it printed.
+#define CAPTURE(out, call)                                                     \
+    do {                                                                       \
+        fflush(stdout);                                                        \
+        int fd = temp_file(), saved = dup(1);                                  \
+        CHECK(saved >= 0 && dup2(fd, 1) == 1);                                 \
+        call;                                                                  \
+        fflush(stdout);                                                        \
+        CHECK(dup2(saved, 1) == 1);                                            \
+        close(saved);                                                          \
+        out = read_all(fd);                                                    \
+        close(fd);                                                             \
+    } while (0)
+
+// `to_string`, the buffered `print`, `fprint` and `print_fd` of `fn` all give
+// the text the unbuffered `old` print gives.
+#define CHECK_SAME(fn, old, v)                                                 \
+    do {                                                                       \
+        char *want, *got;                                                      \
+        CAPTURE(want, old##_print(v));                                         \
+        got = fn##_to_string(v);                                               \
+        CHECK(strcmp(got, want) == 0);                                         \
+        VEC_FREE(got);                                                         \
+        CAPTURE(got, fn##_print(v));                                           \
+        CHECK(strcmp(got, want) == 0);                                         \
+        VEC_FREE(got);                                                         \
+        FILE *file = tmpfile();                                                \
+        CHECK(file && fn##_fprint(file, v) && fflush(file) == 0);              \
+        got = read_all(fileno(file));                                          \
+        CHECK(strcmp(got, want) == 0);                                         \
+        VEC_FREE(got);                                                         \
+        fclose(file);                                                          \
+        int fd = temp_file();                                                  \
+        CHECK(fn##_print_fd(v, fd));                                           \
+        got = read_all(fd);                                                    \
+        CHECK(strcmp(got, want) == 0);                                         \
+        VEC_FREE(got);                                                         \
+        close(fd);                                                             \
+        VEC_FREE(want);                                                        \
+    } while (0)
+
+static void check_ints(ints v) {
+    CHECK_SAME(ints, old_ints, v);
+    CHECK_SAME(flat_ints, old_flat_ints, v);
+    CHECK_SAME(wide_ints, old_wide_ints, v);
+}
+
+int main(void) {
+    // Never allocated and empty vectors.
+    ints v = {0};
+    check_ints(v);
+    char *s = ints_to_string(v);
+    CHECK(strcmp(s, "int[]") == 0);
+    VEC_FREE(s);
+    ints_init(&v);
+    check_ints(v);
+
+    // The integer fast path must agree with printf at the extremes.
+    int edges[] = {0, 1, -1, 9, 10, -10, 99, 100, INT_MAX, INT_MIN, 123456789};
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        ints_push(&v, edges[i]);
+        check_ints(v);
+    }
+    s = flat_ints_to_string(v);
+    CHECK(strcmp(s, "int[  0,  1,  -1,  9,  10,  -10,  99,  100,  2147483647,"
+                    "  -2147483648,  123456789]") == 0);
+    VEC_FREE(s);
+
+    // Enough elements for the buffered prints to flush several blocks.
+    for (int i = 0; i < 20000; i++)
+        ints_push(&v, i * 7919 - 50000000);
+    check_ints(v);
+    ints_clear(&v);
+
+    // Nested vectors indent each level with format_indent.
+    intss n;
+    intss_init(&n);
+    CHECK_SAME(intss, old_intss, n);
+    for (int i = 0; i < 5; i++) {
+        ints row;
+        ints_init(&row);
+        for (int j = 0; j < i; j++)
+            ints_push(&row, i % 2 ? INT_MIN + j : j * 100);
+        intss_push(&n, row);
+    }
+    intss_push(&n, (ints){0});
+    CHECK_SAME(intss, old_intss, n);
+    intss_clear(&n);
+
+    // printf into a buffer that has nothing allocated yet, then past the
+    // first block.
+    vec_buf b;
+    vec_buf_init(&b);
+    vec_buf_printf(&b, "%d", 42);
+    CHECK(b.size == 2 && memcmp(b.data, "42", 2) == 0);
+    vec_buf_printf(&b, "%600d", 7);
+    CHECK(b.size == 602 && b.data[601] == '7' && b.data[2] == ' ');
+    vec_buf_printf(&b, "%s", "");
+    CHECK(b.size == 602);
+    vec_buf_free(&b);
+    vec_buf_init(&b);
+    vec_buf_printf(&b, "%300s", "x");
+    CHECK(b.size == 300 && b.data[299] == 'x' && b.data[300] == '\0');
+    vec_buf_free(&b);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "../vec.h"
+#include "check.h"
+
+vec_define(int, ints);
+vec_define_free_simple(int, ints);
+vec_define_hashindex(int, ints, a, a == b);
+
+// Every value collides with the others in its group of 8, so the probe
+// sequences are long and get shifted around by the Robin Hood insertions.
+vec_define(int, collide);
+vec_define_free_simple(int, collide);
+vec_define_hashindex(int, collide, a / 8, a == b);
+
+static size_t slow_index_of(ints v, int x) {
+    for (size_t i = 0; i < v.size; i++)
+        if (v.data[i] == x)
+            return i;
+    return VEC_NPOS;
+}
+
+int main(void) {
+    ints v;
+    ints_init(&v);
+    for (int i = 0; i < 10000; i++)
+        ints_push(&v, (i * 7919) % 5003);
+
+    vec_hashindex idx;
+    ints_index_build(&idx, v);
+    for (int x = -10; x < 5100; x++)
+        CHECK(ints_index_of(&idx, v, x) == slow_index_of(v, x));
+    CHECK(ints_contains_fast(&idx, v, 0));
+    CHECK(!ints_contains_fast(&idx, v, 5003));
+
+    // The _indexed functions keep the index in step with the vector.
+    ints_push_indexed(&v, &idx, 123456);
+    CHECK(ints_index_of(&idx, v, 123456) == v.size - 1);
+    ints_set_indexed(&v, &idx, 0, 654321);
+    CHECK(ints_index_of(&idx, v, 654321) == 0);
+    CHECK(ints_pop_indexed(&v, &idx) == 123456);
+    CHECK(!ints_contains_fast(&idx, v, 123456));
+    for (int x = -10; x < 5100; x++)
+        CHECK(ints_index_of(&idx, v, x) == slow_index_of(v, x));
+    vec_hashindex_free(&idx);
+
+    size_t size = v.size;
+    CHECK(ints_dedupe(&v) == size - v.size);
+    CHECK(v.size == 5003 + 1);
+    ints_clear(&v);
+
+    collide c;
+    collide_init(&c);
+    vec_hashindex cidx;
+    vec_hashindex_init(&cidx, 0);
+    for (int i = 0; i < 4096; i++)
+        collide_push_indexed(&c, &cidx, i);
+    for (int i = 4095; i >= 2048; i--)
+        CHECK(collide_pop_indexed(&c, &cidx) == i);
+    for (int i = 0; i < 4096; i++)
+        CHECK(collide_index_of(&cidx, c, i) ==
+              (i < 2048 ? (size_t)i : VEC_NPOS));
+    vec_hashindex_free(&cidx);
+    collide_clear(&c);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "../vec.hpp"
+#include "check.h"
+
+#include <string>
+
+typedef struct {
+    int x, y;
+} point;
+
+vec_define(point, points);
+vec_define_free_simple(point, points);
+vec_define_sort(point, points, (a.x > b.x) - (a.x < b.x));
+
+// Long enough to live on the heap, so a lost or doubly freed string shows up
+// under ASan.
+static std::string str(int i) {
+    return "a string that does not fit in the small buffer #" +
+           std::to_string(i);
+}
+
+static void check_strs(const vec::vector<std::string> &v, size_t n) {
+    CHECK(v.size() == n && v.capacity() >= n);
+    for (size_t i = 0; i < n; i++)
+        CHECK(v[i] == str((int)i));
+}
+
+static void test_strings() {
+    vec::vector<std::string> v;
+    for (int i = 0; i < 100; i++)
+        v.push_back(str(i));
+    check_strs(v, 100);
+
+    vec::vector<std::string> copy(v);
+    check_strs(copy, 100);
+    copy[0] = "changed";
+    CHECK(v[0] == str(0));
+    vec::vector<std::string> moved(std::move(copy));
+    CHECK(copy.size() == 0 && copy.data() == nullptr);
+    CHECK(moved.size() == 100 && moved[0] == "changed");
+    moved = v;
+    check_strs(moved, 100);
+
+    CHECK(v.pop_back() == str(99));
+    check_strs(v, 99);
+    v.resize(150, str(7));
+    CHECK(v.size() == 150 && v[149] == str(7));
+    v.resize(50);
+    check_strs(v, 50);
+    v.resize(60);
+    CHECK(v[59].empty());
+    v.resize(50);
+
+    // shrink_to_fit moves the strings into an exact buffer.
+    v.shrink_to_fit();
+    CHECK(v.capacity() == 50);
+    check_strs(v, 50);
+    v.clear();
+    CHECK(v.size() == 0 && v.capacity() == 50);
+    v.shrink_to_fit();
+    CHECK(v.capacity() == 0 && v.data() == nullptr);
+    v.emplace_back(str(0));
+    check_strs(v, 1);
+}
+
+// Appends and pushes of the vector's own elements, with and without room for
+// them, must copy them before the buffer moves.
+template <typename T, typename Make> static void test_self_append(Make make) {
+    vec::vector<T> v;
+    for (int i = 0; i < 8; i++)
+        v.push_back(make(i));
+    v.shrink_to_fit();
+    v.append(v.data() + 2, 5);
+    CHECK(v.size() == 13);
+    for (int i = 0; i < 5; i++)
+        CHECK(v[8 + (size_t)i] == make(i + 2));
+
+    v.resize(8);
+    v.reserve(32);
+    v.append(v.data(), 8);
+    CHECK(v.size() == 16);
+    for (int i = 0; i < 16; i++)
+        CHECK(v[(size_t)i] == make(i % 8));
+
+    v.shrink_to_fit();
+    v.push_back(v[3]);
+    CHECK(v.size() == 17 && v.back() == make(3));
+    v.shrink_to_fit();
+    v.emplace_back(v.front());
+    CHECK(v.size() == 18 && v.back() == make(0));
+}
+
+static bool operator==(const point &a, const point &b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+static void test_c_interop() {
+    // A C vector used from C++ and handed back to the C functions.
+    points c;
+    points_init(&c);
+    points_push(&c, point{3, 0});
+    vec::vector<point> &v = vec::vector<point>::from(c);
+    CHECK(v.size() == 1 && v[0] == (point{3, 0}));
+    for (int i = 0; i < 100; i++)
+        v.push_back(point{(i * 37) % 100, i});
+    CHECK(c.size == 101 && c.data == v.data() && c.capacity == v.capacity());
+    points_sort(&c);
+    for (size_t i = 1; i < v.size(); i++)
+        CHECK(v[i - 1].x <= v[i].x);
+    CHECK(&v.as<points>() == &c);
+    points_clear(&c);
+    CHECK(v.size() == 0 && v.data() == nullptr);
+
+    // A C++ vector passed to the C functions, then freed by its destructor.
+    vec::vector<point> w{{5, 1}, {2, 2}, {9, 3}};
+    points &p = w.as<points>();
+    points_push(&p, point{1, 4});
+    points_sort(&p);
+    CHECK(w.size() == 4 && w.front() == (point{1, 4}) &&
+          w.back() == (point{9, 3}));
+    w.shrink_to_fit();
+    CHECK(w.capacity() == 4 && p.capacity == 4);
+    CHECK(points_pop(&p).x == 9 && w.size() == 3);
+    vec::vector<point> &back = vec::vector<point>::from(p);
+    CHECK(&back == &w);
+}
+
+static void test_const() {
+    vec::vector<int> v{1, 2, 3};
+    const vec::vector<int> &c = v;
+    CHECK(c.front() == 1 && c.back() == 3 && c.at(1) == 2);
+    v.front() = 10;
+    v.back() = 30;
+    CHECK(c.front() == 10 && c.back() == 30);
+    CHECK(c.contains(30) && c.find_index(2) == 1 && !c.contains(4));
+}
+
+int main() {
+    test_strings();
+    test_self_append<int>([](int i) { return i * 3; });
+    test_self_append<std::string>(str);
+    test_c_interop();
+    test_const();
+    return 0;
+}
@@ -0,0 +1,240 @@
+// A small chunk, so elements bigger than it and reads in many pieces are
+// both covered.
+#define VEC_IO_CHUNK 64
+#include "../vec.h"
+#include "check.h"
+
+#include <pthread.h>
+
+vec_define(int, ints);
+vec_define_free_simple(int, ints);
+vec_define_io(int, ints);
+
+typedef struct {
+    unsigned char bytes[100];
+} block;
+
+vec_define(block, blocks);
+vec_define_free_simple(block, blocks);
+vec_define_io(block, blocks);
+
+static char path[] = "/tmp/vec_io_XXXXXX";
+
+static ints make(size_t n) {
+    ints v;
+    ints_init(&v);
+    for (size_t i = 0; i < n; i++)
+        ints_push(&v, (int)(i * 2654435761u));
+    return v;
+}
+
+static bool same(ints a, ints b) {
+    return a.size == b.size &&
+           (a.size == 0 || memcmp(a.data, b.data, sizeof(int) * a.size) == 0);
+}
+
+// Writes `len` bytes to `fd` from another thread in pieces of `piece` bytes,
+// then closes it.
+typedef struct {
+    int fd;
+    const void *data;
+    size_t len, piece;
+} writer;
+
+static void *write_pieces(void *arg) {
+    writer *w = (writer *)arg;
+    const char *p = (const char *)w->data;
+    for (size_t at = 0; at < w->len;) {
+        size_t n = w->len - at < w->piece ? w->len - at : w->piece;
+        ssize_t done = write(w->fd, p + at, n);
+        CHECK(done > 0);
+        at += (size_t)done;
+    }
+    close(w->fd);
+    return NULL;
+}
+
+// Starts a writer thread on a new pipe and returns its read end.
+static int pipe_from(pthread_t *thread, writer *w, const void *data,
+                     size_t len, size_t piece) {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    w->fd = fds[1];
+    w->data = data;
+    w->len = len;
+    w->piece = piece;
+    CHECK(pthread_create(thread, NULL, write_pieces, w) == 0);
+    return fds[0];
+}
+
+// The bytes write_fd produces for `v`.
+static char *serialize(ints v, size_t *len) {
+    *len = sizeof(vec_io_header) + sizeof(int) * v.size;
+    char *bytes = (char *)malloc(*len);
+    CHECK(bytes);
+    int fd = open(path, O_RDWR | O_TRUNC);
+    CHECK(fd >= 0 && ints_write_fd(v, fd));
+    CHECK(lseek(fd, 0, SEEK_SET) == 0 && _vec_read_all(fd, bytes, *len));
+    close(fd);
+    return bytes;
+}
+
+static void save(const void *bytes, size_t len) {
+    int fd = open(path, O_WRONLY | O_TRUNC);
+    CHECK(fd >= 0 && (size_t)write(fd, bytes, len) == len);
+    close(fd);
+}
+
+// Reads `bytes` from the file and from a pipe into a vector that already
+// has elements: both must fail with EINVAL and leave the vector empty.
+static void check_rejected(const char *bytes, size_t len) {
+    save(bytes, len);
+    ints v = make(10);
+    errno = 0;
+    CHECK(!ints_read_file(&v, path) && errno == EINVAL && v.size == 0);
+
+    ints_push(&v, 1);
+    pthread_t thread;
+    writer w;
+    int fd = pipe_from(&thread, &w, bytes, len, 4096);
+    errno = 0;
+    CHECK(!ints_read_fd(&v, fd) && errno == EINVAL && v.size == 0);
+    char rest[256];
+    while (read(fd, rest, sizeof(rest)) > 0)
+        ;
+    close(fd);
+    pthread_join(thread, NULL);
+    ints_clear(&v);
+}
+
+int main(void) {
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    // Round trips through a file and through a pipe, replacing what the
+    // vector held before.
+    static const size_t sizes[] = {0, 1, 15, 16, 17, 1000, 100000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        ints v = make(sizes[s]), r = make(7);
+        CHECK(ints_write_file(v, path));
+        CHECK(ints_read_file(&r, path) && same(r, v));
+
+        size_t len;
+        char *bytes = serialize(v, &len);
+        pthread_t thread;
+        writer w;
+        fd = pipe_from(&thread, &w, bytes, len, 1000);
+        ints_push(&r, 5);
+        CHECK(ints_read_fd(&r, fd) && same(r, v));
+        close(fd);
+        pthread_join(thread, NULL);
+        free(bytes);
+        ints_clear(&v);
+        ints_clear(&r);
+    }
+
+    // Corrupt headers, truncated data and checksum mismatches.
+    ints v = make(100);
+    size_t len;
+    char *bytes = serialize(v, &len);
+    vec_io_header header;
+    memcpy(&header, bytes, sizeof(header));
+    char *bad = (char *)malloc(len);
+    CHECK(bad);
+#define CORRUPT(change)                                                        \
+    do {                                                                       \
+        memcpy(bad, bytes, len);                                               \
+        vec_io_header h = header;                                              \
+        change;                                                                \
+        memcpy(bad, &h, sizeof(h));                                            \
+        check_rejected(bad, len);                                              \
+    } while (0)
+    CORRUPT(h.magic[0] = 'x');
+    CORRUPT(h.version++);
+    CORRUPT(h.elem_size = 8);
+    CORRUPT(h.size++);
+    CORRUPT(h.checksum ^= 1);
+    CORRUPT(bad[len - 1] ^= 1);
+    // A count far past the input, which must not be allocated up front.
+    CORRUPT(h.size = (uint64_t)1 << 40);
+    check_rejected(bytes, sizeof(header) - 1);
+    check_rejected(bytes, len - 1);
+    check_rejected(bytes, 0);
+    free(bad);
+    free(bytes);
+
+    // Elements bigger than VEC_IO_CHUNK go through the pipe one at a time.
+    blocks b, rb;
+    blocks_init(&b);
+    blocks_init(&rb);
+    for (int i = 0; i < 50; i++) {
+        block x;
+        memset(x.bytes, i, sizeof(x.bytes));
+        blocks_push(&b, x);
+    }
+    CHECK(blocks_write_file(b, path));
+    fd = open(path, O_RDONLY);
+    CHECK(fd >= 0);
+    char copy[8192];
+    ssize_t n = read(fd, copy, sizeof(copy));
+    CHECK(n > 0);
+    close(fd);
+    pthread_t thread;
+    writer w;
+    fd = pipe_from(&thread, &w, copy, (size_t)n, 333);
+    CHECK(blocks_read_fd(&rb, fd) && rb.size == b.size);
+    CHECK(memcmp(rb.data, b.data, sizeof(block) * b.size) == 0);
+    close(fd);
+    pthread_join(thread, NULL);
+
+    // And a count far past the input is only allocated as data arrives.
+    vec_io_header h;
+    memcpy(&h, copy, sizeof(h));
+    h.size = (uint64_t)1 << 40;
+    memcpy(copy, &h, sizeof(h));
+    fd = pipe_from(&thread, &w, copy, (size_t)n, 4096);
+    errno = 0;
+    CHECK(!blocks_read_fd(&rb, fd) && errno == EINVAL && rb.size == 0);
+    close(fd);
+    pthread_join(thread, NULL);
+    blocks_clear(&b);
+    blocks_clear(&rb);
+
+    // read_stream over a pipe written in pieces that split elements.
+    ints r;
+    ints_init(&r);
+    fd = pipe_from(&thread, &w, v.data, sizeof(int) * v.size, 7);
+    CHECK(ints_read_stream(&r, fd) && same(r, v));
+    close(fd);
+    pthread_join(thread, NULL);
+
+    // reader_step on a non-blocking pipe, one read at a time.
+    ints_clear(&r);
+    fd = pipe_from(&thread, &w, v.data, sizeof(int) * v.size, 5);
+    CHECK(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0);
+    ints_reader reader;
+    ints_reader_init(&reader, fd);
+    size_t steps = 0;
+    while (!reader.eof) {
+        ssize_t got = ints_reader_step(&r, &reader);
+        CHECK(got >= 0);
+        steps++;
+    }
+    CHECK(same(r, v) && steps > 1);
+    close(fd);
+    pthread_join(thread, NULL);
+
+    // Input that ends inside an element is an error.
+    ints_clear(&r);
+    fd = pipe_from(&thread, &w, v.data, sizeof(int) * 3 + 2, 64);
+    errno = 0;
+    CHECK(!ints_read_stream(&r, fd) && errno == EINVAL);
+    close(fd);
+    pthread_join(thread, NULL);
+
+    ints_clear(&r);
+    ints_clear(&v);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <sys/wait.h>
+
+vec_define_mmap(int, ints);
+vec_define_mmap(int64_t, longs);
+
+static char path[] = "/tmp/vec_mmap_XXXXXX";
+
+static size_t file_size(void) {
+    struct stat st;
+    CHECK(stat(path, &st) == 0);
+    return (size_t)st.st_size;
+}
+
+static void check_seq(ints v, size_t n) {
+    CHECK(v.size == n);
+    for (size_t i = 0; i < n; i++)
+        CHECK(v.data[i] == (int)i * 3);
+}
+
+int main(void) {
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    // An empty file gets a header and grows with the vector.
+    ints v;
+    CHECK(ints_open(&v, path));
+    CHECK(v.size == 0 && file_size() == _VCMMAP_HEADER);
+    for (int i = 0; i < 10000; i++)
+        ints_push(&v, i * 3);
+    check_seq(v, 10000);
+    CHECK(file_size() == _VCMMAP_HEADER + sizeof(int) * v.capacity);
+
+    // `sync` saves the size, a read-only mapping opened meanwhile sees it.
+    CHECK(ints_sync(&v));
+    ints r;
+    CHECK(ints_open_readonly(&r, path));
+    check_seq(r, 10000);
+    ints_close(&r);
+    ints_close(&v);
+    CHECK(v.data == NULL && v.fd == -1);
+
+    // Reopening reloads the elements, shrinking truncates the file.
+    CHECK(ints_open(&v, path));
+    check_seq(v, 10000);
+    ints_erase_range(&v, 100, 10000);
+    ints_shrink(&v);
+    check_seq(v, 100);
+    CHECK(file_size() == _VCMMAP_HEADER + sizeof(int) * 100);
+    ints_push(&v, 300);
+    ints_close(&v);
+    CHECK(ints_open(&v, path));
+    check_seq(v, 101);
+    ints_close(&v);
+
+    // Changes to a read-only mapping stay in memory.
+    CHECK(ints_open_readonly(&r, path));
+    check_seq(r, 101);
+    r.data[0] = -1;
+    r.size = 50;
+    CHECK(ints_sync(&r));
+    ints_close(&r);
+    CHECK(ints_open_readonly(&r, path));
+    check_seq(r, 101);
+
+    // Growing it fails with EROFS, in a child since that exits.
+    fflush(stderr);
+    int pipes[2];
+    CHECK(pipe(pipes) == 0);
+    pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        dup2(pipes[1], STDERR_FILENO);
+        errno = 0;
+        ints_reserve(&r, r.capacity + 1);
+        _exit(0);
+    }
+    close(pipes[1]);
+    char msg[256] = {0};
+    size_t got = 0;
+    ssize_t n;
+    while ((n = read(pipes[0], msg + got, sizeof(msg) - 1 - got)) > 0)
+        got += (size_t)n;
+    close(pipes[0]);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE);
+    CHECK(strstr(msg, "mmap vector is read-only"));
+    CHECK(strstr(msg, strerror(EROFS)));
+    ints_close(&r);
+
+    // Files of another element type or without a header are rejected.
+    longs l;
+    errno = 0;
+    CHECK(!longs_open(&l, path) && errno == EINVAL);
+    fd = open(path, O_WRONLY | O_TRUNC);
+    CHECK(fd >= 0 && write(fd, "vec", 3) == 3);
+    close(fd);
+    errno = 0;
+    CHECK(!ints_open(&v, path) && errno == EINVAL);
+    CHECK(truncate(path, 0) == 0);
+    errno = 0;
+    CHECK(!ints_open_readonly(&r, path) && errno == EINVAL);
+
+    unlink(path);
+    return 0;
+}
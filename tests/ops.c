@@ -0,0 +1,160 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <limits.h>
+
+vec_define(int, ints);
+vec_define_free_simple(int, ints);
+vec_define_ops_map(int, ints, scale, a * *(int *)ctx + 1);
+vec_define_ops_reduce(int, ints, sum, long long, 0, acc + a, acc + b);
+// Counts the elements and remembers the first odd one of its range, the
+// combine keeps the first part's, so joining the parts out of order shows.
+typedef struct {
+    size_t count;
+    int first_odd;
+} odd_acc;
+vec_define_ops_reduce(int, ints, first_odd, odd_acc, ((odd_acc){0, INT_MIN}),
+                      ((odd_acc){acc.count + 1,
+                                 acc.first_odd == INT_MIN && a % 2
+                                     ? a
+                                     : acc.first_odd}),
+                      ((odd_acc){acc.count + b.count,
+                                 acc.first_odd == INT_MIN ? b.first_odd
+                                                          : acc.first_odd}));
+vec_define_ops_filter(int, ints, multiples, a % *(int *)ctx == 0);
+vec_define_ops_for_each(int, ints, add,
+                        __atomic_add_fetch((long long *)ctx, a,
+                                           __ATOMIC_RELAXED));
+vec_define_ops_minmax(int, ints, (a > b) - (a < b));
+
+// Above VEC_PARALLEL_THRESHOLD and uneven for every thread count.
+#define COUNT (VEC_PARALLEL_THRESHOLD * 2 + 77)
+
+static const size_t thread_counts[] = {1, 3, 8, 0};
+#define THREAD_COUNTS (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+static uint64_t state = 88172645463325252ULL;
+
+static uint64_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static ints make(size_t n) {
+    ints v;
+    ints_init(&v);
+    for (size_t i = 0; i < n; i++)
+        ints_push(&v, (int)(next() % 2001) - 1000);
+    return v;
+}
+
+static bool same(ints a, ints b) {
+    return a.size == b.size &&
+           (a.size == 0 || memcmp(a.data, b.data, sizeof(int) * a.size) == 0);
+}
+
+// Runs every parallel op at every thread count and compares it with the
+// serial one and with a plain loop.
+static void check_ops(ints v) {
+    long long sum = 0;
+    size_t odd = VEC_NPOS, lo = VEC_NPOS, hi = VEC_NPOS;
+    for (size_t i = 0; i < v.size; i++) {
+        sum += v.data[i];
+        if (odd == VEC_NPOS && v.data[i] % 2)
+            odd = i;
+        if (lo == VEC_NPOS || v.data[i] < v.data[lo])
+            lo = i;
+        if (hi == VEC_NPOS || v.data[i] > v.data[hi])
+            hi = i;
+    }
+    CHECK(ints_sum(v, NULL) == sum);
+    odd_acc acc = ints_first_odd(v, NULL);
+    CHECK(acc.count == v.size);
+    CHECK(acc.first_odd == (odd == VEC_NPOS ? INT_MIN : v.data[odd]));
+    CHECK(ints_argmin(v) == lo && ints_argmax(v) == hi);
+    if (v.size)
+        CHECK(ints_min(v) == v.data[lo] && ints_max(v) == v.data[hi]);
+
+    int three = 3;
+    ints expected, out;
+    ints_init(&expected);
+    ints_init(&out);
+    ints_multiples(v, &expected, &three);
+    for (size_t i = 0, k = 0; i < v.size; i++)
+        if (v.data[i] % 3 == 0)
+            CHECK(k < expected.size && expected.data[k++] == v.data[i]);
+
+    ints mapped;
+    ints_init(&mapped);
+    ints_extend(&mapped, v);
+    ints_scale(&mapped, &three);
+    for (size_t i = 0; i < v.size; i++)
+        CHECK(mapped.data[i] == v.data[i] * 3 + 1);
+
+    for (size_t t = 0; t < THREAD_COUNTS; t++) {
+        size_t threads = thread_counts[t];
+        CHECK(ints_parallel_sum(v, NULL, threads) == sum);
+        odd_acc pacc = ints_parallel_first_odd(v, NULL, threads);
+        CHECK(pacc.count == acc.count && pacc.first_odd == acc.first_odd);
+        CHECK(ints_parallel_argmin(v, threads) == lo);
+        CHECK(ints_parallel_argmax(v, threads) == hi);
+        if (v.size) {
+            CHECK(ints_parallel_min(v, threads) == v.data[lo]);
+            CHECK(ints_parallel_max(v, threads) == v.data[hi]);
+        }
+
+        // The parallel filter keeps the order and replaces stale contents.
+        ints_push(&out, 12345);
+        ints_parallel_multiples(v, &out, &three, threads);
+        CHECK(same(out, expected));
+
+        ints w;
+        ints_init(&w);
+        ints_extend(&w, v);
+        ints_parallel_scale(&w, &three, threads);
+        CHECK(same(w, mapped));
+        ints_clear(&w);
+
+        long long total = 0;
+        ints_parallel_add(v, &total, threads);
+        CHECK(total == sum);
+    }
+    ints_clear(&expected);
+    ints_clear(&out);
+    ints_clear(&mapped);
+}
+
+int main(void) {
+    // Below and above the threshold, and empty.
+    static const size_t sizes[] = {0, 1, 1000, COUNT};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        ints v = make(sizes[s]);
+        check_ops(v);
+        ints_clear(&v);
+    }
+
+    // Equal extremes in every part: the first one must win, also when a
+    // later part finds its own copy first.
+    ints v = make(COUNT);
+    for (size_t i = 0; i < COUNT; i += COUNT / 16) {
+        v.data[i] = 5000;
+        v.data[i + 1] = -5000;
+    }
+    check_ops(v);
+    CHECK(ints_parallel_argmax(v, 8) == 0 && ints_parallel_argmin(v, 8) == 1);
+
+    // Nothing odd, and nothing passes the filter.
+    for (size_t i = 0; i < v.size; i++)
+        v.data[i] = 2 * (int)(i % 1000) + 2;
+    check_ops(v);
+    int big = 1 << 30;
+    ints out;
+    ints_init(&out);
+    ints_parallel_multiples(v, &out, &big, 8);
+    CHECK(out.size == 0);
+    ints_clear(&out);
+    ints_clear(&v);
+    return 0;
+}
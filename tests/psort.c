@@ -0,0 +1,163 @@
+#include "../vec.h"
+#include "check.h"
+
+// `payload` is the position before sorting, so a stable sort keeps it
+// increasing within every key.
+typedef struct {
+    int key;
+    size_t payload;
+} item;
+
+vec_define(item, items);
+vec_define_free_simple(item, items);
+vec_define_sort(item, items, (a.key > b.key) - (a.key < b.key));
+
+vec_define(int, ints);
+vec_define_free_simple(int, ints);
+vec_define_sort_radix(int, ints);
+
+// Above VEC_PARALLEL_THRESHOLD and not a multiple of any thread count, so
+// the chunks and the merge rounds are uneven.
+#define COUNT (VEC_PARALLEL_THRESHOLD * 3 + 101)
+
+static const size_t thread_counts[] = {1, 3, 8};
+#define THREAD_COUNTS (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+static uint64_t state = 88172645463325252ULL;
+
+static uint64_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+enum { RANDOM, FEW, SORTED, REVERSED, PATTERNS };
+
+static items make(int pattern) {
+    items v;
+    items_init(&v);
+    for (size_t i = 0; i < COUNT; i++) {
+        item x = {0, i};
+        switch (pattern) {
+        case RANDOM:
+            x.key = (int)(next() % 1000);
+            break;
+        case FEW:
+            x.key = (int)(next() % 3);
+            break;
+        case SORTED:
+            x.key = (int)(i / 7);
+            break;
+        default:
+            x.key = (int)((COUNT - i) / 7);
+        }
+        items_push(&v, x);
+    }
+    return v;
+}
+
+static items copy(items v) {
+    items w;
+    items_init(&w);
+    items_extend(&w, v);
+    return w;
+}
+
+static bool same(items a, items b) {
+    if (a.size != b.size)
+        return false;
+    for (size_t i = 0; i < a.size; i++)
+        if (a.data[i].key != b.data[i].key ||
+            a.data[i].payload != b.data[i].payload)
+            return false;
+    return true;
+}
+
+// Sorted by key in the given direction, equal keys in their old order.
+static void check_stable(items v, bool reversed) {
+    for (size_t i = 1; i < v.size; i++) {
+        item a = v.data[i - 1], b = v.data[i];
+        CHECK(reversed ? a.key >= b.key : a.key <= b.key);
+        CHECK(a.key != b.key || a.payload < b.payload);
+    }
+}
+
+// Sorted by key and still a permutation of the input.
+static void check_sorted(items v, bool reversed) {
+    bool *seen = (bool *)calloc(v.size, sizeof(bool));
+    CHECK(seen);
+    for (size_t i = 0; i < v.size; i++) {
+        CHECK(i == 0 || (reversed ? v.data[i - 1].key >= v.data[i].key
+                                  : v.data[i - 1].key <= v.data[i].key));
+        CHECK(v.data[i].payload < v.size && !seen[v.data[i].payload]);
+        seen[v.data[i].payload] = true;
+    }
+    free(seen);
+}
+
+int main(void) {
+    for (int p = 0; p < PATTERNS; p++) {
+        items input = make(p);
+
+        // The stable sorts give the serial stable result at every thread
+        // count.
+        items expected = copy(input), expected_rev = copy(input);
+        items_sort_stable(&expected);
+        items_sort_stable_reversed(&expected_rev);
+        check_stable(expected, false);
+        check_stable(expected_rev, true);
+        for (size_t t = 0; t < THREAD_COUNTS; t++) {
+            items v = copy(input);
+            items_parallel_sort_stable(&v, thread_counts[t]);
+            CHECK(same(v, expected));
+            items_clear(&v);
+            v = copy(input);
+            items_parallel_sort_stable_reversed(&v, thread_counts[t]);
+            CHECK(same(v, expected_rev));
+            items_clear(&v);
+
+            // The unstable ones sort and keep every element, and give the
+            // same result when run again with the same thread count.
+            v = copy(input);
+            items w = copy(input);
+            items_parallel_sort(&v, thread_counts[t]);
+            items_parallel_sort(&w, thread_counts[t]);
+            check_sorted(v, false);
+            CHECK(same(v, w));
+            items_clear(&v);
+            items_clear(&w);
+            v = copy(input);
+            items_parallel_sort_reversed(&v, thread_counts[t]);
+            check_sorted(v, true);
+            items_clear(&v);
+        }
+        items_clear(&expected);
+        items_clear(&expected_rev);
+        items_clear(&input);
+    }
+
+    // Radix sorted chunks merged in parallel.
+    ints a, b;
+    ints_init(&a);
+    ints_init(&b);
+    for (size_t i = 0; i < COUNT; i++)
+        ints_push(&a, (int)next());
+    ints_extend(&b, a);
+    ints_sort(&b);
+    for (size_t t = 0; t < THREAD_COUNTS; t++) {
+        ints v;
+        ints_init(&v);
+        ints_extend(&v, a);
+        ints_parallel_sort(&v, thread_counts[t]);
+        CHECK(v.size == b.size &&
+              memcmp(v.data, b.data, sizeof(int) * v.size) == 0);
+        ints_parallel_sort_reversed(&v, thread_counts[t]);
+        for (size_t i = 0; i < v.size; i++)
+            CHECK(v.data[i] == b.data[v.size - 1 - i]);
+        ints_clear(&v);
+    }
+    ints_clear(&a);
+    ints_clear(&b);
+    return 0;
+}
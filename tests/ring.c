@@ -0,0 +1,171 @@
+#include "../vec.h"
+#include "check.h"
+
+vec_define_ring(int, rings);
+vec_define_free_simple(int, rings);
+vec_define_sort(int, rings, (a > b) - (a < b));
+
+// The expected elements, from model[lo] to model[hi - 1].
+#define MODEL 400000
+static int model[2 * MODEL];
+static size_t lo = MODEL, hi = MODEL;
+
+static uint64_t state = 88172645463325252ULL;
+
+static uint64_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static void check_model(rings v) {
+    CHECK(v.size == hi - lo && v.size <= v.capacity);
+    CHECK(v.capacity == 0 || v.head < v.capacity);
+    for (size_t i = 0; i < v.size; i++)
+        CHECK(rings_at(v, i) == model[lo + i]);
+    CHECK(v.size == 0 || (*rings_front(v) == model[lo] &&
+                          *rings_back(v) == model[hi - 1]));
+}
+
+static void push_back(rings *v, int x) {
+    rings_push_back(v, x);
+    model[hi++] = x;
+}
+
+static void push_front(rings *v, int x) {
+    rings_push_front(v, x);
+    model[--lo] = x;
+}
+
+static bool wrapped(rings v) { return v.head + v.size > v.capacity; }
+
+int main(void) {
+    rings v;
+    rings_init(&v);
+    CHECK(rings_empty(v) && rings_front(v) == NULL && rings_back(v) == NULL);
+
+    // Interleaved pushes and pops at the front keep the ring wrapped.
+    for (int i = 0; i < 3; i++)
+        push_back(&v, i);
+    for (int i = 0; i < 1000; i++) {
+        push_front(&v, -i);
+        if (i % 3 == 0) {
+            CHECK(rings_pop_front(&v) == model[lo]);
+            lo++;
+        }
+        check_model(v);
+    }
+
+    // Growing a wrapped ring with a short wrapped part copies it past the
+    // old end, with a long one it moves the head part to the new end.
+    for (int round = 0; round < 2; round++) {
+        rings_clear(&v);
+        lo = hi = MODEL;
+        rings_reserve(&v, 16);
+        for (int i = 0; i < 16; i++)
+            push_back(&v, i);
+        for (int i = 0; i < (round ? 12 : 4); i++) {
+            CHECK(rings_pop_front(&v) == model[lo]);
+            lo++;
+            push_back(&v, 100 + i);
+        }
+        CHECK(wrapped(v) && v.size == v.capacity);
+        size_t head = v.head, first = v.capacity - v.head;
+        push_back(&v, 1000);
+        check_model(v);
+        if (round == 0)
+            CHECK(v.head == head && !wrapped(v));
+        else
+            CHECK(v.head == v.capacity - first && wrapped(v));
+        for (int i = 0; i < 100; i++)
+            push_front(&v, -i);
+        check_model(v);
+    }
+
+    // Random operations against the model.
+    rings_clear(&v);
+    lo = hi = MODEL;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t r = next();
+        int x = (int)(r >> 32);
+        switch (r % 8) {
+        case 0:
+        case 1:
+        case 2:
+            push_back(&v, x);
+            break;
+        case 3:
+        case 4:
+            push_front(&v, x);
+            break;
+        case 5:
+            if (hi > lo)
+                CHECK(rings_pop_front(&v) == model[lo++]);
+            break;
+        case 6:
+            if (hi > lo)
+                CHECK(rings_pop_back(&v) == model[--hi]);
+            break;
+        default:
+            if (hi > lo) {
+                size_t k = (size_t)(r >> 8) % (hi - lo);
+                rings_set(&v, k, x);
+                model[lo + k] = x;
+            }
+        }
+        if (i % 4096 == 0) {
+            check_model(v);
+            if (i % 3 == 0)
+                rings_shrink(&v);
+        }
+    }
+    check_model(v);
+
+    // `linearize` unwraps in place or through a new buffer, after which the
+    // elements are a plain array.
+    for (int round = 0; round < 2; round++) {
+        rings_clear(&v);
+        lo = hi = MODEL;
+        rings_reserve(&v, 64);
+        for (int i = 0; i < 40; i++)
+            push_back(&v, i);
+        for (int i = 0; i < 30; i++)
+            lo++, rings_pop_front(&v);
+        for (int i = 0; i < (round ? 40 : 10); i++)
+            push_back(&v, 40 + i);
+        CHECK(round ? wrapped(v) : !wrapped(v) && v.head > 0);
+        int *data = rings_linearize(&v);
+        CHECK(data == v.data && v.head == 0);
+        for (size_t i = 0; i < v.size; i++)
+            CHECK(data[i] == model[lo + i]);
+        check_model(v);
+        rings_sort_reversed(&v);
+        for (size_t i = 1; i < v.size; i++)
+            CHECK(data[i - 1] >= data[i]);
+        rings_sort(&v);
+        for (size_t i = 0; i < v.size; i++)
+            CHECK(data[i] == model[lo + i]);
+    }
+
+    // Shrinking a wrapped ring keeps its order.
+    rings_clear(&v);
+    lo = hi = MODEL;
+    rings_reserve(&v, 32);
+    for (int i = 0; i < 20; i++)
+        push_back(&v, i);
+    for (int i = 0; i < 18; i++)
+        lo++, rings_pop_front(&v);
+    for (int i = 0; i < 16; i++)
+        push_back(&v, 20 + i);
+    CHECK(wrapped(v));
+    rings_shrink(&v);
+    CHECK(v.capacity == 18 && v.head == 0);
+    check_model(v);
+
+    rings w;
+    CHECK(rings_take(&v, &w));
+    CHECK(v.size == 0 && v.data == NULL && w.size == 18);
+    rings_clear(&w);
+    return 0;
+}
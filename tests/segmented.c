@@ -0,0 +1,100 @@
+#include "../vec.h"
+#include "check.h"
+
+vec_define_segmented(int, segs);
+vec_define_segmented_contains(int, segs, a == b);
+vec_define_segmented_sort(int, segs, (a > b) - (a < b));
+
+#define COUNT 100000
+
+static uint64_t state = 88172645463325252ULL;
+
+static int next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (int)(state % 1000);
+}
+
+static int cmp_int(const void *x, const void *y) {
+    int a = *(const int *)x, b = *(const int *)y;
+    return (a > b) - (a < b);
+}
+
+int main(void) {
+    segs v;
+    segs_init(&v);
+    CHECK(segs_empty(&v) && segs_back(&v) == NULL);
+
+    // Pointers taken while pushing stay valid through every later segment.
+    int **ptrs = (int **)malloc(sizeof(int *) * COUNT);
+    CHECK(ptrs);
+    for (int i = 0; i < COUNT; i++) {
+        segs_push(&v, i);
+        ptrs[i] = segs_back(&v);
+        CHECK(ptrs[i] == segs_ptr(&v, (size_t)i));
+    }
+    for (int i = 0; i < COUNT; i++)
+        CHECK(*ptrs[i] == i && segs_at(&v, (size_t)i) == i);
+    CHECK(v.capacity >= COUNT && v.segment_count < _VCSEG_COUNT);
+    CHECK(segs_find_index(&v, COUNT - 1) == COUNT - 1);
+    CHECK(segs_find_index(&v, 17) == 17);
+    CHECK(!segs_contains(&v, COUNT));
+
+    // Popping and pushing again reuses the same slots.
+    for (int i = 0; i < 1000; i++)
+        CHECK(segs_pop(&v) == COUNT - 1 - i);
+    for (int i = COUNT - 1000; i < COUNT; i++)
+        segs_push(&v, -i);
+    for (int i = 0; i < COUNT; i++)
+        CHECK(*ptrs[i] == (i < COUNT - 1000 ? i : -i));
+
+    // Reversing swaps the elements in place.
+    segs_reverse(&v);
+    for (int i = 0; i < COUNT; i++) {
+        int k = COUNT - 1 - i;
+        CHECK(*ptrs[i] == (k < COUNT - 1000 ? k : -k));
+    }
+
+    // Sorting agrees with qsort at sizes inside the first segment, on a
+    // segment boundary and across many segments.
+    static const size_t sizes[] = {0, 1, 15, 16, 17, 48, 49, 1000, COUNT};
+    int *expected = (int *)malloc(sizeof(int) * COUNT);
+    CHECK(expected);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        segs_clear(&v);
+        for (size_t i = 0; i < n; i++) {
+            expected[i] = next();
+            segs_push(&v, expected[i]);
+        }
+        int *first = n ? segs_ptr(&v, 0) : NULL;
+        qsort(expected, n, sizeof(int), cmp_int);
+        segs_sort(&v);
+        CHECK(v.size == n);
+        for (size_t i = 0; i < n; i++)
+            CHECK(segs_at(&v, i) == expected[i]);
+        segs_sort_reversed(&v);
+        for (size_t i = 0; i < n; i++)
+            CHECK(segs_at(&v, i) == expected[n - 1 - i]);
+        CHECK(!n || segs_ptr(&v, 0) == first);
+    }
+    free(expected);
+
+    // Shrinking frees the segments past the last element only.
+    segs_clear(&v);
+    CHECK(v.segment_count == 0 && v.capacity == 0);
+    for (int i = 0; i < 100; i++)
+        segs_push(&v, i);
+    int *kept = segs_ptr(&v, 19);
+    while (v.size > 20)
+        segs_pop(&v);
+    segs_shrink(&v);
+    CHECK(v.segment_count == 2 && v.capacity == 48);
+    CHECK(segs_ptr(&v, 19) == kept && *kept == 19);
+    segs_reserve(&v, 1000);
+    CHECK(v.capacity >= 1000);
+    segs_clear(&v);
+    free(ptrs);
+    return 0;
+}
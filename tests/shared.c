@@ -0,0 +1,86 @@
+#include "../vec.h"
+#include "check.h"
+
+vec_define_shared(int, shared_ints);
+vec_define_free_simple(int, shared_ints);
+
+// Elements that own memory: `live` counts the strings not freed yet, so a
+// double free or a leak through a shared buffer shows up in the count.
+typedef char *str;
+static int live;
+
+static str make(int i) {
+    str s = (str)malloc(16);
+    CHECK(s);
+    snprintf(s, 16, "%d", i);
+    live++;
+    return s;
+}
+
+static void release(str s) {
+    live--;
+    free(s);
+}
+
+vec_define_shared(str, strs);
+vec_define_free(str, strs, release(a));
+
+// The optional methods can use a prefix of their own.
+vec_define_sort2(int, shared_ints, by_value, (a > b) - (a < b));
+vec_define_remove_if2(int, shared_ints, odd, a % 2 != 0);
+
+int main(void) {
+    shared_ints v;
+    shared_ints_init(&v);
+    for (int i = 0; i < 100; i++)
+        shared_ints_push(&v, 99 - i);
+
+    // A clone shares the buffer until one side changes it.
+    shared_ints copy = shared_ints_clone(&v);
+    CHECK(copy.data == v.data && *v.refs == 2);
+    CHECK(shared_ints_is_shared(&v) && shared_ints_is_shared(&copy));
+    by_value_sort(&copy);
+    CHECK(copy.data != v.data && *v.refs == 1);
+    CHECK(!shared_ints_is_shared(&v) && !shared_ints_is_shared(&copy));
+    for (int i = 0; i < 100; i++)
+        CHECK(copy.data[i] == i && v.data[i] == 99 - i);
+    CHECK(odd_remove_if(&copy, NULL) == 50 && copy.size == 50);
+
+    // A view borrows the elements and copies them once it's changed.
+    shared_ints view = shared_ints_slice(v, 10, 20);
+    CHECK(shared_ints_is_view(&view) && view.data == v.data + 10);
+    shared_ints_push(&view, -1);
+    CHECK(!shared_ints_is_view(&view) && view.data != v.data + 10);
+    CHECK(view.size == 11 && view.data[0] == 89 && v.data[10] == 89);
+    shared_ints_clear(&view);
+
+    // Three owners: the buffer is freed by the last one.
+    shared_ints a = shared_ints_clone(&v), b = shared_ints_clone(&v);
+    CHECK(*v.refs == 3);
+    shared_ints_clear(&a);
+    CHECK(*v.refs == 2);
+    shared_ints_clear(&v);
+    CHECK(*b.refs == 1 && b.data[0] == 99);
+    shared_ints_clear(&b);
+    shared_ints_clear(&copy);
+
+    // vec_define_free only frees the elements through the last reference.
+    strs s;
+    strs_init(&s);
+    for (int i = 0; i < 50; i++)
+        strs_push(&s, make(i));
+    strs clone = strs_clone(&s);
+    strs slice = strs_slice(s, 5, 25);
+    strs_clear(&slice);
+    CHECK(live == 50);
+    strs_resize(&clone, 10, NULL);
+    CHECK(live == 50 && clone.data != s.data && strcmp(s.data[49], "49") == 0);
+    clone.size = 0; // the ten kept strings are still s's
+    strs_clear(&clone);
+    strs more = strs_clone(&s);
+    strs_clear(&s);
+    CHECK(live == 50 && strcmp(more.data[49], "49") == 0);
+    strs_clear(&more);
+    CHECK(live == 0);
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <float.h>
+#include <math.h>
+
+vec_define(int8_t, i8s);
+vec_define_free_simple(int8_t, i8s);
+vec_define_search_primitive(int8_t, i8s);
+vec_define(int16_t, i16s);
+vec_define_free_simple(int16_t, i16s);
+vec_define_search_primitive(int16_t, i16s);
+vec_define(int32_t, i32s);
+vec_define_free_simple(int32_t, i32s);
+vec_define_search_primitive(int32_t, i32s);
+vec_define(int64_t, i64s);
+vec_define_free_simple(int64_t, i64s);
+vec_define_search_primitive(int64_t, i64s);
+vec_define(float, f32s);
+vec_define_free_simple(float, f32s);
+vec_define_search_primitive(float, f32s);
+vec_define(double, f64s);
+vec_define_free_simple(double, f64s);
+vec_define_search_primitive(double, f64s);
+
+// Every length up to a few AVX2 registers of bytes, so each width gets full
+// registers followed by every possible tail, plus a few longer ones.
+#define MAX_LEN 140
+static const size_t extra[] = {255, 256, 257, 1000, 1031};
+#define EXTRA (sizeof(extra) / sizeof(extra[0]))
+
+// Checks the searches of `v` for `x` against the scalar loop and against the
+// expected first, last and count.
+#define CHECK_SEARCH(name, v, x, first, last, cnt)                             \
+    do {                                                                       \
+        CHECK(name##_find_index(v, x) == (first));                             \
+        CHECK(name##_find_last(v, x) == (last));                               \
+        CHECK(name##_count(v, x) == (cnt));                                    \
+        CHECK(name##_contains(v, x) == ((cnt) != 0));                          \
+        CHECK(name##_scalar_find_index(v, x) == (first));                      \
+        CHECK(name##_scalar_find_last(v, x) == (last));                        \
+        CHECK(name##_scalar_count(v, x) == (cnt));                             \
+    } while (0)
+
+// Counts the matches of `x` in `v` with a plain loop.
+#define EXPECT(v, x, first, last, cnt)                                         \
+    do {                                                                       \
+        first = last = VEC_NPOS;                                               \
+        cnt = 0;                                                               \
+        for (size_t k = 0; k < v.size; k++) {                                  \
+            if (v.data[k] == (x)) {                                            \
+                if (first == VEC_NPOS)                                         \
+                    first = k;                                                 \
+                last = k;                                                      \
+                cnt++;                                                         \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+// Fills a vector of length n with `fill` and searches for `x`: first with no
+// match, then with a single match at every position (the last ones land in
+// the scalar tail), then with every third element and the last one matching.
+#define TEST(name, type)                                                       \
+    static void test_##name##_len(size_t n, type fill, type x) {               \
+        name v;                                                                \
+        name##_init(&v);                                                       \
+        for (size_t i = 0; i < n; i++)                                         \
+            name##_push(&v, fill);                                             \
+        CHECK_SEARCH(name, v, x, VEC_NPOS, VEC_NPOS, 0);                       \
+        for (size_t i = 0; i < n; i++) {                                       \
+            v.data[i] = x;                                                     \
+            CHECK_SEARCH(name, v, x, i, i, 1);                                 \
+            v.data[i] = fill;                                                  \
+        }                                                                      \
+        for (size_t i = 0; i < n; i += 3)                                      \
+            v.data[i] = x;                                                     \
+        if (n)                                                                 \
+            v.data[n - 1] = x;                                                 \
+        size_t first, last, cnt;                                               \
+        EXPECT(v, x, first, last, cnt);                                        \
+        CHECK_SEARCH(name, v, x, first, last, cnt);                            \
+        EXPECT(v, fill, first, last, cnt);                                     \
+        CHECK_SEARCH(name, v, fill, first, last, cnt);                         \
+        name##_clear(&v);                                                      \
+    }                                                                          \
+                                                                               \
+    static void test_##name(type fill, type x) {                               \
+        for (size_t n = 0; n <= MAX_LEN; n++)                                  \
+            test_##name##_len(n, fill, x);                                     \
+        for (size_t k = 0; k < EXTRA; k++)                                     \
+            test_##name##_len(extra[k], fill, x);                              \
+    }
+TEST(i8s, int8_t)
+TEST(i16s, int16_t)
+TEST(i32s, int32_t)
+TEST(i64s, int64_t)
+TEST(f32s, float)
+TEST(f64s, double)
+
+int main(void) {
+    // `fill` and `x` differ in a single bit, in the low and in the high byte,
+    // so a kernel comparing the wrong bytes or too few of them finds matches.
+    test_i8s(0x10, 0x11);
+    test_i8s(0, -128);
+    test_i16s(0x1234, 0x1235);
+    test_i16s(0x1234, 0x1234 | INT16_MIN);
+    test_i32s(7, 6);
+    test_i32s(7, 7 | INT32_MIN);
+    test_i64s(7, 6);
+    test_i64s(7, 7 | INT64_MIN);
+    test_i64s(7, 7 | (int64_t)1 << 32);
+    test_f32s(1.5f, -1.5f);
+    test_f32s(1.0f, 1.0f + FLT_EPSILON);
+    test_f64s(1.5, -1.5);
+    test_f64s(1.0, 1.0 + DBL_EPSILON);
+
+    // Floats compare with ==: -0.0 finds 0.0 and NaN finds nothing.
+    f32s f;
+    f64s d;
+    f32s_init(&f);
+    f64s_init(&d);
+    for (size_t i = 0; i < 37; i++) {
+        f32s_push(&f, i == 35 ? 0.0f : (float)i + 1);
+        f64s_push(&d, i == 35 ? 0.0 : (double)i + 1);
+    }
+    CHECK_SEARCH(f32s, f, -0.0f, 35, 35, 1);
+    CHECK_SEARCH(f64s, d, -0.0, 35, 35, 1);
+    f.data[3] = NAN;
+    d.data[3] = NAN;
+    CHECK_SEARCH(f32s, f, NAN, VEC_NPOS, VEC_NPOS, 0);
+    CHECK_SEARCH(f64s, d, NAN, VEC_NPOS, VEC_NPOS, 0);
+    f32s_clear(&f);
+    f64s_clear(&d);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#define VEC_STATS
+#include "../vec.h"
+#include "check.h"
+
+#define N 4
+
+vec_define_small(int, smalls, N);
+vec_define_free_simple(int, smalls);
+
+// Strings, so a lost, copied twice or double freed element shows up under
+// the sanitizers.
+typedef char *str;
+vec_define_small(str, small_strs, N);
+vec_define_free(str, small_strs, free(a));
+
+static str make(int i) {
+    str s = (str)malloc(16);
+    CHECK(s);
+    snprintf(s, 16, "%d", i);
+    return s;
+}
+
+// The first `n` elements of `v` are 0, 1, 2...
+static void check_seq(smalls v, size_t n) {
+    CHECK(v.size == n);
+    for (size_t i = 0; i < n; i++)
+        CHECK(v.data[i] == (int)i);
+}
+
+static void check_strs(small_strs v, size_t n) {
+    char buf[16];
+    CHECK(v.size == n);
+    for (size_t i = 0; i < n; i++) {
+        snprintf(buf, sizeof(buf), "%d", (int)i);
+        CHECK(strcmp(v.data[i], buf) == 0);
+    }
+}
+
+int main(void) {
+    vec_stats *stats = smalls_stats();
+
+    // Up to N elements nothing is allocated.
+    smalls v;
+    smalls_init(&v);
+    CHECK(smalls_is_inline(v) && v.capacity == N && v.data == v.inline_data);
+    for (int i = 0; i < N; i++)
+        smalls_push(&v, i);
+    check_seq(v, N);
+    CHECK(smalls_is_inline(v) && stats->allocs == 0);
+
+    // One more moves the elements to the heap.
+    smalls_push(&v, N);
+    check_seq(v, N + 1);
+    CHECK(!smalls_is_inline(v) && v.data != v.inline_data);
+    CHECK(stats->allocs == 1 && stats->live == sizeof(int) * v.capacity);
+    for (int i = N + 1; i < 100; i++)
+        smalls_push(&v, i);
+    check_seq(v, 100);
+
+    // Shrinking above N stays on the heap, at N or below it goes back inline
+    // and frees the heap buffer.
+    smalls_erase_range(&v, 10, 100);
+    smalls_shrink(&v);
+    check_seq(v, 10);
+    CHECK(!smalls_is_inline(v) && v.capacity == 10);
+    smalls_erase_range(&v, 3, 10);
+    smalls_shrink(&v);
+    check_seq(v, 3);
+    CHECK(smalls_is_inline(v) && v.data == v.inline_data);
+    CHECK(stats->frees == 1 && stats->live == 0);
+
+    // Inserting past N from inline storage, then shrinking exactly to N.
+    int items[] = {3, 4, 5, 6, 7};
+    smalls_append_n(&v, items, 5);
+    check_seq(v, 8);
+    CHECK(!smalls_is_inline(v));
+    smalls_erase_range(&v, N, 8);
+    smalls_shrink(&v);
+    check_seq(v, N);
+    CHECK(smalls_is_inline(v));
+
+    // Appending the inline elements to themselves moves them to the heap.
+    smalls_append_n(&v, v.data, v.size);
+    CHECK(v.size == 2 * N && !smalls_is_inline(v));
+    for (size_t i = 0; i < v.size; i++)
+        CHECK(v.data[i] == (int)(i % N));
+
+    // Reserving and clearing.
+    smalls_clear(&v);
+    CHECK(v.size == 0 && smalls_is_inline(v));
+    smalls_init_reserved(&v, N / 2);
+    CHECK(smalls_is_inline(v));
+    smalls_init_reserved(&v, 50);
+    CHECK(!smalls_is_inline(v) && v.capacity == 50);
+    smalls_clear(&v);
+    CHECK(smalls_is_inline(v) && stats->live == 0);
+    CHECK(stats->allocs == stats->frees);
+
+    // `take` copies inline elements into the other struct and hands over a
+    // heap buffer, the source is left empty and inline either way.
+    smalls w;
+    for (int i = 0; i < 3; i++)
+        smalls_push(&v, i);
+    CHECK(smalls_take(&v, &w));
+    check_seq(w, 3);
+    CHECK(w.data == w.inline_data && v.size == 0 && smalls_is_inline(v));
+    for (int i = 0; i < 20; i++)
+        smalls_push(&v, i);
+    int *heap = v.data;
+    smalls_clear(&w);
+    CHECK(smalls_take(&v, &w));
+    check_seq(w, 20);
+    CHECK(w.data == heap && v.size == 0 && smalls_is_inline(v));
+    smalls_clear(&w);
+    smalls_clear(&v);
+    CHECK(stats->live == 0 && stats->allocs == stats->frees);
+
+    // Elements that own memory survive every transition and are freed once.
+    small_strs s;
+    small_strs_init(&s);
+    for (int round = 0; round < 3; round++) {
+        for (int i = (int)s.size; i < 40; i++)
+            small_strs_push(&s, make(i));
+        check_strs(s, 40);
+        while (s.size > 2)
+            free(small_strs_pop(&s));
+        small_strs_shrink(&s);
+        check_strs(s, 2);
+        CHECK(small_strs_is_inline(s));
+    }
+    small_strs_clear(&s);
+    CHECK(small_strs_is_inline(s) && s.size == 0);
+    return 0;
+}
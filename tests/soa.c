@@ -0,0 +1,110 @@
+#define VEC_STATS
+#include "../vec.h"
+#include "check.h"
+
+// Columns of different widths, so permuting them can't share a stride.
+vec_define_soa(rows, (double, x), (int, key), (char, tag), (size_t, id));
+vec_define_soa_sort(rows, int, key, (a > b) - (a < b));
+vec_define_soa_sort(rows, double, x, (a > b) - (a < b));
+vec_define_soa_find(rows, int, key, a == b);
+vec_define_soa_find(rows, char, tag, a == b);
+
+#define COUNT 5000
+
+static rows_record make(size_t i) {
+    rows_record r;
+    r.x = (double)((i * 7919) % COUNT) / 4;
+    r.key = (int)(i % 37);
+    r.tag = (char)('a' + i % 26);
+    r.id = i;
+    return r;
+}
+
+static bool same(rows_record a, rows_record b) {
+    return a.x == b.x && a.key == b.key && a.tag == b.tag && a.id == b.id;
+}
+
+static bool aligned(const void *p) {
+    return ((uintptr_t)p & (_VCSOA_ALIGN - 1)) == 0;
+}
+
+int main(void) {
+    vec_stats *stats = rows_stats();
+    const size_t row = sizeof(double) + sizeof(int) + 1 + sizeof(size_t);
+
+    // Every column grows with the vector and keeps its elements.
+    rows v;
+    rows_init(&v);
+    CHECK(v.capacity == 4 && stats->allocs == 4 && stats->live == row * 4);
+    for (size_t i = 0; i < COUNT; i++) {
+        rows_push(&v, make(i));
+        CHECK(v.size <= v.capacity);
+    }
+    CHECK(v.size == COUNT && stats->live == row * v.capacity);
+    CHECK(stats->peak_used == row * COUNT);
+    CHECK(aligned(rows_x(&v)) && aligned(rows_key(&v)) &&
+          aligned(rows_tag(&v)) && aligned(rows_id(&v)));
+    for (size_t i = 0; i < COUNT; i++)
+        CHECK(same(rows_at(&v, i), make(i)));
+    CHECK(rows_key(&v)[40] == 3 && rows_tag(&v)[27] == 'b');
+
+    rows_record r = make(3);
+    r.id = COUNT;
+    rows_set(&v, 10, r);
+    CHECK(same(rows_at(&v, 10), r));
+    rows_set(&v, 10, make(10));
+    CHECK(same(rows_pop(&v), make(COUNT - 1)));
+    rows_push(&v, make(COUNT - 1));
+
+    // Finding reads a single column.
+    CHECK(rows_find_key(&v, 0) == 0 && rows_find_key(&v, 36) == 36);
+    CHECK(rows_find_key(&v, 37) == VEC_NPOS);
+    CHECK(rows_find_tag(&v, 'z') == 25 && rows_find_tag(&v, 'A') == VEC_NPOS);
+
+    // Sorting by a field moves every column with it and keeps equal keys in
+    // their old order, which `id` still records.
+    rows_sort_by_key(&v);
+    for (size_t i = 0; i < COUNT; i++) {
+        rows_record got = rows_at(&v, i);
+        CHECK(same(got, make(got.id)));
+        if (i > 0) {
+            rows_record prev = rows_at(&v, i - 1);
+            CHECK(prev.key < got.key ||
+                  (prev.key == got.key && prev.id < got.id));
+        }
+    }
+    CHECK(rows_find_key(&v, 0) == 0 && rows_find_key(&v, 1) == COUNT / 37 + 1);
+    rows_sort_by_key_reversed(&v);
+    for (size_t i = 1; i < COUNT; i++) {
+        rows_record prev = rows_at(&v, i - 1), got = rows_at(&v, i);
+        CHECK(same(got, make(got.id)));
+        CHECK(prev.key > got.key || (prev.key == got.key && prev.id < got.id));
+    }
+    rows_sort_by_x(&v);
+    for (size_t i = 1; i < COUNT; i++)
+        CHECK(rows_x(&v)[i - 1] <= rows_x(&v)[i]);
+    for (size_t i = 0; i < COUNT; i++)
+        CHECK(same(rows_at(&v, i), make(rows_id(&v)[i])));
+
+    // An explicit permutation reverses the rows.
+    size_t *perm = (size_t *)malloc(sizeof(size_t) * COUNT);
+    CHECK(perm);
+    for (size_t i = 0; i < COUNT; i++)
+        perm[i] = COUNT - 1 - i;
+    rows_record first = rows_at(&v, 0);
+    rows_permute(&v, perm);
+    CHECK(same(rows_at(&v, COUNT - 1), first));
+    free(perm);
+
+    // Shrinking and clearing release every column.
+    while (v.size > 10)
+        rows_pop(&v);
+    rows_shrink(&v);
+    CHECK(v.capacity == 10 && stats->live == row * 10);
+    CHECK(stats->shrinks == 4);
+    rows_clear(&v);
+    CHECK(v.capacity == 0 && stats->live == 0);
+    CHECK(stats->allocs == stats->frees && stats->frees == 4);
+    CHECK(vec_stats_global.live == 0);
+    return 0;
+}
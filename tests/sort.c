@@ -0,0 +1,155 @@
+#include "../vec.h"
+#include "check.h"
+
+#include <math.h>
+
+vec_define(int, ints);
+vec_define_free_simple(int, ints);
+vec_define_sort(int, ints, (a > b) - (a < b));
+
+vec_define(int, rints);
+vec_define_free_simple(int, rints);
+vec_define_sort_radix(int, rints);
+vec_define(int64_t, longs);
+vec_define_free_simple(int64_t, longs);
+vec_define_sort_radix(int64_t, longs);
+vec_define(uint8_t, bytes);
+vec_define_free_simple(uint8_t, bytes);
+vec_define_sort_radix(uint8_t, bytes);
+vec_define(float, floats);
+vec_define_free_simple(float, floats);
+vec_define_sort_radix(float, floats);
+vec_define(double, doubles);
+vec_define_free_simple(double, doubles);
+vec_define_sort_radix(double, doubles);
+
+static uint64_t state = 88172645463325252ULL;
+
+static uint64_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// qsort comparisons the results are checked against.
+#define CMP(name, type)                                                        \
+    static int name(const void *x, const void *y) {                            \
+        type a = *(const type *)x, b = *(const type *)y;                       \
+        return (a > b) - (a < b);                                              \
+    }                                                                          \
+    static int name##_rev(const void *x, const void *y) { return name(y, x); }
+CMP(cmp_int, int)
+CMP(cmp_long, int64_t)
+CMP(cmp_byte, uint8_t)
+CMP(cmp_float, float)
+CMP(cmp_double, double)
+
+// Sizes around the insertion sort and radix thresholds.
+static const size_t sizes[] = {0,  1,  2,   3,   15,  16,  17,   31,  32,
+                               33, 64, 255, 256, 257, 1000, 4097, 20000};
+#define SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+enum { RANDOM, SORTED, REVERSED, EQUAL, FEW, ORGAN, PATTERNS };
+
+static int pattern(int p, size_t i, size_t n) {
+    switch (p) {
+    case RANDOM:
+        return (int)next();
+    case SORTED:
+        return (int)i - 1000;
+    case REVERSED:
+        return (int)(n - i);
+    case EQUAL:
+        return 7;
+    case FEW:
+        return (int)(next() % 4) - 2;
+    default:
+        return (int)(i < n / 2 ? i : n - i);
+    }
+}
+
+// Sorts `v` with `sort` and a copy with qsort and compares them with `==`,
+// so -0.0 and 0.0 count as equal like they do for the comparison.
+#define CHECK_SORT(name, type, sort, cmp)                                      \
+    do {                                                                       \
+        type *expected = (type *)malloc(sizeof(type) * (v.size + 1));          \
+        CHECK(expected);                                                       \
+        if (v.size)                                                            \
+            memcpy(expected, v.data, sizeof(type) * v.size);                   \
+        qsort(expected, v.size, sizeof(type), cmp);                            \
+        sort(&v);                                                              \
+        for (size_t k = 0; k < v.size; k++)                                    \
+            CHECK(v.data[k] == expected[k]);                                   \
+        free(expected);                                                        \
+    } while (0)
+
+// Fills `v` with `count` values from `value` and checks both directions.
+#define CHECK_BOTH(name, type, cmp, count, value)                              \
+    do {                                                                       \
+        name v;                                                                \
+        name##_init(&v);                                                       \
+        for (size_t i = 0; i < (count); i++)                                   \
+            name##_push(&v, (type)(value));                                    \
+        name w;                                                                \
+        name##_init(&w);                                                       \
+        name##_extend(&w, v);                                                  \
+        CHECK_SORT(name, type, name##_sort, cmp);                              \
+        name##_clear(&v);                                                      \
+        v = w;                                                                 \
+        CHECK_SORT(name, type, name##_sort_reversed, cmp##_rev);               \
+        name##_clear(&v);                                                      \
+    } while (0)
+
+int main(void) {
+    for (size_t s = 0; s < SIZES; s++) {
+        size_t n = sizes[s];
+        for (int p = 0; p < PATTERNS; p++) {
+            CHECK_BOTH(ints, int, cmp_int, n, pattern(p, i, n));
+            CHECK_BOTH(rints, int, cmp_int, n, pattern(p, i, n));
+
+            // The stable sort agrees too, stability itself is checked with
+            // the parallel sorts.
+            ints v;
+            ints_init(&v);
+            for (size_t i = 0; i < n; i++)
+                ints_push(&v, pattern(p, i, n));
+            CHECK_SORT(ints, int, ints_sort_stable, cmp_int);
+            ints_clear(&v);
+        }
+
+        // Heapsort, which the introsort falls back to past its depth limit.
+        ints v;
+        ints_init(&v);
+        for (size_t i = 0; i < n; i++)
+            ints_push(&v, pattern(RANDOM, i, n) % 100);
+        int *expected = (int *)malloc(sizeof(int) * (n + 1));
+        CHECK(expected);
+        if (n)
+            memcpy(expected, v.data, sizeof(int) * n);
+        qsort(expected, n, sizeof(int), cmp_int);
+        ints_sort_range_intro(v.data, n, 0);
+        for (size_t k = 0; k < n; k++)
+            CHECK(v.data[k] == expected[k]);
+        ints_clear(&v);
+        free(expected);
+
+        // Radix keys: signs, extremes and both zeros.
+        CHECK_BOTH(longs, int64_t, cmp_long, n,
+                   i % 5 == 0   ? INT64_MIN
+                   : i % 5 == 1 ? INT64_MAX
+                                : (int64_t)next());
+        CHECK_BOTH(bytes, uint8_t, cmp_byte, n, next());
+        CHECK_BOTH(floats, float, cmp_float, n,
+                   i % 4 == 0   ? -0.0f
+                   : i % 4 == 1 ? 0.0f
+                                : (float)(int32_t)next() / 1e5f);
+        CHECK_BOTH(doubles, double, cmp_double, n,
+                   i % 6 == 0   ? -0.0
+                   : i % 6 == 1 ? 0.0
+                   : i % 6 == 2 ? -INFINITY
+                   : i % 6 == 3 ? INFINITY
+                                : (double)(int64_t)next() / 1e9);
+    }
+    return 0;
+}
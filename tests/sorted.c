@@ -0,0 +1,171 @@
+#include "../vec.h"
+#include "check.h"
+
+// `tag` records where an element came from, so the tests can tell which of
+// two equal elements the functions kept.
+typedef struct {
+    int key, tag;
+} item;
+
+vec_define(item, items);
+vec_define_free_simple(item, items);
+vec_define_sorted(item, items, (a.key > b.key) - (a.key < b.key));
+
+#define KEYS 12
+
+static uint64_t state = 88172645463325252ULL;
+
+static uint64_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// A sorted vector of `n` random keys with duplicates, tagged from `tag` up.
+static items make(size_t n, int tag) {
+    items v;
+    items_init(&v);
+    for (size_t i = 0; i < n; i++) {
+        item x = {(int)(next() % KEYS), tag + (int)i};
+        items_insert_sorted(&v, x);
+    }
+    return v;
+}
+
+static bool same(item a, item b) { return a.key == b.key && a.tag == b.tag; }
+
+// Elements of `v` with key `k`, starting at `*i`, which is moved past them.
+static size_t run(items v, int k, size_t *i) {
+    size_t start = *i;
+    while (*i < v.size && v.data[*i].key == k)
+        (*i)++;
+    return *i - start;
+}
+
+// Appends `n` elements of `v` from `from` to `out`.
+static void take(items *out, items v, size_t from, size_t n) {
+    items_append_n(out, v.data + from, n);
+}
+
+// The multiset results, key by key: union keeps max(ca, cb) elements, the
+// first ones from `a`; intersection keeps the first min(ca, cb) of `a`;
+// difference keeps the last ca - cb of `a`; merge keeps all of `a` and then
+// all of `b`.
+static void check_ops(items a, items b) {
+    items expect_union, expect_inter, expect_diff, expect_merge, out;
+    items_init(&expect_union);
+    items_init(&expect_inter);
+    items_init(&expect_diff);
+    items_init(&expect_merge);
+    items_init(&out);
+    size_t i = 0, j = 0;
+    while (i < a.size || j < b.size) {
+        int k = j == b.size || (i < a.size && a.data[i].key < b.data[j].key)
+                    ? a.data[i].key
+                    : b.data[j].key;
+        size_t ai = i, bj = j;
+        size_t ca = run(a, k, &i), cb = run(b, k, &j);
+        size_t common = ca < cb ? ca : cb;
+        take(&expect_union, a, ai, ca);
+        if (cb > ca)
+            take(&expect_union, b, bj + ca, cb - ca);
+        take(&expect_inter, a, ai, common);
+        take(&expect_diff, a, ai + common, ca - common);
+        take(&expect_merge, a, ai, ca);
+        take(&expect_merge, b, bj, cb);
+    }
+
+#define CHECK_OUT(expected)                                                    \
+    do {                                                                       \
+        CHECK(out.size == expected.size);                                      \
+        for (size_t k = 0; k < out.size; k++)                                  \
+            CHECK(same(out.data[k], expected.data[k]));                        \
+    } while (0)
+
+    // `out` starts with stale contents, which must be replaced.
+    item stale = {-1, -1};
+    items_push(&out, stale);
+    items_set_union(a, b, &out);
+    CHECK_OUT(expect_union);
+    items_set_intersection(a, b, &out);
+    CHECK_OUT(expect_inter);
+    items_set_difference(a, b, &out);
+    CHECK_OUT(expect_diff);
+    items_merge(a, b, &out);
+    CHECK_OUT(expect_merge);
+#undef CHECK_OUT
+
+    items_clear(&expect_union);
+    items_clear(&expect_inter);
+    items_clear(&expect_diff);
+    items_clear(&expect_merge);
+    items_clear(&out);
+}
+
+int main(void) {
+    // insert_sorted keeps equal keys in insertion order.
+    items v = make(500, 0);
+    for (size_t i = 1; i < v.size; i++)
+        CHECK(v.data[i - 1].key < v.data[i].key ||
+              (v.data[i - 1].key == v.data[i].key &&
+               v.data[i - 1].tag < v.data[i].tag));
+
+    // The bounds enclose every element of a key.
+    for (int k = -1; k <= KEYS; k++) {
+        item x = {k, 0};
+        size_t lo = items_lower_bound(v, x), hi = items_upper_bound(v, x);
+        CHECK(lo <= hi && hi <= v.size);
+        for (size_t i = 0; i < v.size; i++)
+            CHECK((v.data[i].key < k) == (i < lo) &&
+                  (v.data[i].key <= k) == (i < hi));
+        CHECK(items_binary_contains(v, x) == (lo < hi));
+    }
+
+    // Set operations on sets with duplicates, disjoint, equal and empty sets.
+    static const size_t sizes[] = {0, 1, 2, 5, 30, 300};
+    for (size_t s = 0; s < 6; s++) {
+        for (size_t t = 0; t < 6; t++) {
+            items a = make(sizes[s], 0), b = make(sizes[t], 1000);
+            check_ops(a, b);
+            check_ops(b, a);
+            check_ops(a, a);
+            items_clear(&a);
+            items_clear(&b);
+        }
+    }
+    items a = make(100, 0), b;
+    items_init(&b);
+    for (int i = 0; i < 50; i++) {
+        item x = {KEYS + i, 1000 + i};
+        items_push(&b, x);
+    }
+    check_ops(a, b);
+    check_ops(b, a);
+    items_clear(&a);
+    items_clear(&b);
+
+    // unique keeps the first element of every run of equal keys.
+    item before[KEYS];
+    size_t keys = 0;
+    for (size_t i = 0; i < v.size; i++)
+        if (i == 0 || v.data[i - 1].key != v.data[i].key)
+            before[keys++] = v.data[i];
+    size_t size = v.size;
+    CHECK(items_unique(&v) == size - keys);
+    CHECK(v.size == keys);
+    for (size_t i = 0; i < keys; i++)
+        CHECK(same(v.data[i], before[i]));
+    CHECK(items_unique(&v) == 0 && v.size == keys);
+    items_clear(&v);
+    CHECK(items_unique(&v) == 0 && v.size == 0);
+    item one = {3, 3};
+    items_push(&v, one);
+    items_push(&v, one);
+    CHECK(items_unique(&v) == 1 && v.size == 1);
+    CHECK(items_lower_bound(v, one) == 0 && items_upper_bound(v, one) == 1);
+    items_clear(&v);
+    CHECK(items_lower_bound(v, one) == 0 && items_upper_bound(v, one) == 0);
+    CHECK(!items_binary_contains(v, one));
+    return 0;
+}
@@ -13,164 +13,4212 @@
  * License: MIT
  */
 
+#include <errno.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// These macros select the allocator used by vec.h. Define them before
+// including vec.h to route every vector, and the memory the functions use
+// internally, through your own allocator. The columns of vec_define_soa
+// vectors are the exception, they are allocated with aligned_alloc.
+#ifndef VEC_MALLOC
+#define VEC_MALLOC(size) malloc(size)
+#endif
+#ifndef VEC_REALLOC
+#define VEC_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+#ifndef VEC_FREE
+#define VEC_FREE(ptr) free(ptr)
+#endif
 
 // This macro is used to create a unique function name by concatenating
 #define _VCFN(fn_name, op) fn_name##_##op
+// These macros tell apart the primitive types at compile time. Comparing with
+// 1 instead of 0 keeps -Wtype-limits quiet for unsigned types.
+#define _VCISFLOAT(type) ((type)0.5 != 0)
+#define _VCISSIGNED(type) ((type)-1 < (type)1)
 // This macro determines the indentation multiplier
 // Basically if you set this to 2 and use _VCINDENT(3) it will print 3 * 2 = 6
 // spaces.
 #define _VCINDENT_MULT 2
 #define _VCINDENT(indent)                                                      \
     do {                                                                       \
-        for (size_t __i1 = 0; __i1 < (indent) * _VCINDENT_MULT; __i1++)        \
-            putchar(' ');                                                      \
+        printf("%*s", (int)((indent) * _VCINDENT_MULT), "");                   \
     } while (0)
 
-#define vec_define(type, name) vec_define2(type, name, name)
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define _VC_HAS_MMAP 1
+#endif
+
+// Capacity a full vector grows to when an element is pushed. Define it before
+// including vec.h to change the growth policy of every vector.
+#ifndef VEC_GROWTH
+#define VEC_GROWTH(capacity)                                                   \
+    ((capacity) > 1 ? (capacity) + ((capacity) >> 1) : 2)
+#endif
+
+// VEC_GROWTH, but always at least one more than `capacity` so a push can't
+// run past the buffer when a custom policy returns a capacity that is too
+// small.
+static inline size_t _vec_grow_capacity(size_t capacity) {
+    size_t n = VEC_GROWTH(capacity);
+    return n > capacity ? n : capacity + 1;
+}
+
+// Whether `p` points into the `bytes` long buffer at `data`.
+static inline bool _vec_aliases(const void *p, const void *data,
+                                size_t bytes) {
+    return (uintptr_t)p - (uintptr_t)data < bytes;
+}
+
+// Returned by the find functions when there's no match.
+#define VEC_NPOS ((size_t)-1)
+
+// Heap buffers of at least this many bytes are mapped directly with mmap and
+// grown with mremap, which moves pages instead of copying the elements.
+// 0 disables it. With VEC_MMAP_HUGEPAGE defined the mappings are also marked
+// with MADV_HUGEPAGE. Buffers must be freed by the vector functions then.
+#ifndef VEC_MMAP_THRESHOLD
+#define VEC_MMAP_THRESHOLD 0
+#endif
+
+#if defined(_VC_HAS_MMAP) && !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#if defined(_VC_HAS_MMAP) && defined(MAP_ANONYMOUS)
+static inline bool _vec_heap_is_mapped(size_t size) {
+#if VEC_MMAP_THRESHOLD > 0
+    return size >= (size_t)VEC_MMAP_THRESHOLD;
+#else
+    (void)size;
+    return false;
+#endif
+}
+
+static inline size_t _vec_page_round(size_t size) {
+    static size_t page = 0;
+    if (page == 0)
+        page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+static inline void _vec_map_advise(void *ptr, size_t size) {
+#if defined(VEC_MMAP_HUGEPAGE) && defined(MADV_HUGEPAGE)
+    madvise(ptr, size, MADV_HUGEPAGE);
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+static inline void *_vec_map_alloc(size_t size) {
+    size = _vec_page_round(size);
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+    _vec_map_advise(ptr, size);
+    return ptr;
+}
+#else
+#define _vec_heap_is_mapped(size) false
+#define _vec_map_alloc(size) NULL
+#define _vec_page_round(size) (size)
+#endif
+
+// Byte-level allocation helpers shared by every heap backed vector. They take
+// the old and new sizes so that allocators that need them can be plugged in.
+static inline void *_vec_heap_alloc(size_t size) {
+    if (_vec_heap_is_mapped(size))
+        return _vec_map_alloc(size);
+    return VEC_MALLOC(size);
+}
+
+static inline void _vec_heap_free(void *ptr, size_t size) {
+#if defined(_VC_HAS_MMAP) && defined(MAP_ANONYMOUS)
+    if (ptr && _vec_heap_is_mapped(size)) {
+        munmap(ptr, _vec_page_round(size));
+        return;
+    }
+#endif
+    (void)size;
+    VEC_FREE(ptr);
+}
+
+static inline void *_vec_heap_realloc(void *ptr, size_t old_size,
+                                      size_t new_size) {
+    bool old_mapped = _vec_heap_is_mapped(old_size);
+    bool new_mapped = _vec_heap_is_mapped(new_size);
+    if (!old_mapped && !new_mapped)
+        return VEC_REALLOC(ptr, new_size);
+#if defined(MREMAP_MAYMOVE) && defined(MAP_ANONYMOUS)
+    if (old_mapped && new_mapped) {
+        size_t old_len = _vec_page_round(old_size);
+        size_t new_len = _vec_page_round(new_size);
+        if (old_len == new_len)
+            return ptr;
+        void *new_ptr = mremap(ptr, old_len, new_len, MREMAP_MAYMOVE);
+        if (new_ptr == MAP_FAILED)
+            return NULL;
+        _vec_map_advise(new_ptr, new_len);
+        return new_ptr;
+    }
+#endif
+    void *new_ptr = _vec_heap_alloc(new_size);
+    if (!new_ptr)
+        return NULL;
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    _vec_heap_free(ptr, old_size);
+    return new_ptr;
+}
+
+// Runtime allocator interface used by vec_define_alloc vectors. `ctx` is passed
+// back to every callback, sizes are in bytes and returning NULL means failure.
+typedef struct vec_allocator {
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} vec_allocator;
+
+static inline void *_vec_heap_alloc_cb(void *ctx, size_t size) {
+    (void)ctx;
+    return _vec_heap_alloc(size);
+}
+
+static inline void *_vec_heap_realloc_cb(void *ctx, void *ptr, size_t old_size,
+                                         size_t new_size) {
+    (void)ctx;
+    return _vec_heap_realloc(ptr, old_size, new_size);
+}
+
+static inline void _vec_heap_free_cb(void *ctx, void *ptr, size_t size) {
+    (void)ctx;
+    _vec_heap_free(ptr, size);
+}
+
+// The allocator used by vec_define vectors, exposed as a vec_allocator.
+static inline const vec_allocator *vec_heap_allocator(void) {
+    static const vec_allocator heap = {_vec_heap_alloc_cb, _vec_heap_realloc_cb,
+                                       _vec_heap_free_cb, NULL};
+    return &heap;
+}
+
+// Every pointer handed out by the arena and the pool is aligned to this.
+#define _VCALIGN 16
+#define _VCALIGN_UP(n) (((n) + (_VCALIGN - 1)) & ~(size_t)(_VCALIGN - 1))
+
+typedef struct vec_arena_block {
+    struct vec_arena_block *next;
+    size_t size, used;
+} vec_arena_block;
+
+#define _VCARENA_HEADER _VCALIGN_UP(sizeof(vec_arena_block))
+#define _VCARENA_DATA(block) ((char *)(block) + _VCARENA_HEADER)
+
+// Bump allocator. Memory is carved out of blocks of `block_size` bytes and is
+// only given back all at once by vec_arena_reset, which keeps the blocks
+// around for reuse. The last allocation can be grown and freed in place, which
+// is what a single growing vector does most of the time.
+// The arena must not be moved after vec_arena_init, `allocator` points to it.
+typedef struct {
+    vec_allocator allocator;
+    vec_arena_block *head, *current;
+    size_t block_size;
+    void *last;
+} vec_arena;
+
+static inline void *vec_arena_alloc(vec_arena *arena, size_t size) {
+    size = _VCALIGN_UP(size == 0 ? 1 : size);
+    vec_arena_block *block = arena->current;
+    if (block && block->size - block->used < size) {
+        vec_arena_block *next = block->next;
+        if (next && next->size >= size) {
+            next->used = 0;
+            block = next;
+        } else {
+            block = NULL;
+        }
+    }
+    if (!block) {
+        size_t block_size =
+            size > arena->block_size ? size : arena->block_size;
+        block = (vec_arena_block *)VEC_MALLOC(_VCARENA_HEADER + block_size);
+        if (!block)
+            return NULL;
+        block->size = block_size;
+        block->used = 0;
+        if (arena->current) {
+            block->next = arena->current->next;
+            arena->current->next = block;
+        } else {
+            block->next = NULL;
+            arena->head = block;
+        }
+    }
+    arena->current = block;
+    void *ptr = _VCARENA_DATA(block) + block->used;
+    block->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+static inline void *vec_arena_realloc(vec_arena *arena, void *ptr,
+                                      size_t old_size, size_t new_size) {
+    if (!ptr)
+        return vec_arena_alloc(arena, new_size);
+    if (ptr == arena->last) {
+        vec_arena_block *block = arena->current;
+        size_t offset = (size_t)((char *)ptr - _VCARENA_DATA(block));
+        size_t size = _VCALIGN_UP(new_size == 0 ? 1 : new_size);
+        if (block->size - offset >= size) {
+            block->used = offset + size;
+            return ptr;
+        }
+    }
+    void *new_ptr = vec_arena_alloc(arena, new_size);
+    if (new_ptr)
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    return new_ptr;
+}
+
+static inline void vec_arena_free(vec_arena *arena, void *ptr, size_t size) {
+    (void)size;
+    if (ptr && ptr == arena->last) {
+        arena->current->used = (size_t)((char *)ptr -
+                                        _VCARENA_DATA(arena->current));
+        arena->last = NULL;
+    }
+}
+
+// Releases every allocation at once in O(1), the blocks are kept for reuse.
+static inline void vec_arena_reset(vec_arena *arena) {
+    arena->current = arena->head;
+    if (arena->head)
+        arena->head->used = 0;
+    arena->last = NULL;
+}
+
+static inline void *_vec_arena_alloc_cb(void *ctx, size_t size) {
+    return vec_arena_alloc((vec_arena *)ctx, size);
+}
+
+static inline void *_vec_arena_realloc_cb(void *ctx, void *ptr,
+                                          size_t old_size, size_t new_size) {
+    return vec_arena_realloc((vec_arena *)ctx, ptr, old_size, new_size);
+}
+
+static inline void _vec_arena_free_cb(void *ctx, void *ptr, size_t size) {
+    vec_arena_free((vec_arena *)ctx, ptr, size);
+}
+
+static inline void vec_arena_init(vec_arena *arena, size_t block_size) {
+    arena->allocator.alloc = _vec_arena_alloc_cb;
+    arena->allocator.realloc = _vec_arena_realloc_cb;
+    arena->allocator.free = _vec_arena_free_cb;
+    arena->allocator.ctx = arena;
+    arena->head = arena->current = NULL;
+    arena->block_size = block_size == 0 ? 4096 : block_size;
+    arena->last = NULL;
+}
+
+// Gives the blocks back to the system, the arena can't be used afterwards.
+static inline void vec_arena_destroy(vec_arena *arena) {
+    vec_arena_block *block = arena->head;
+    while (block) {
+        vec_arena_block *next = block->next;
+        VEC_FREE(block);
+        block = next;
+    }
+    arena->head = arena->current = NULL;
+    arena->last = NULL;
+}
+
+// Number of power of two size classes in a pool, starting from 16 bytes.
+// Bigger allocations come straight from the pool's arena.
+#ifndef VEC_POOL_CLASSES
+#define VEC_POOL_CLASSES 20
+#endif
+#define _VCPOOL_MIN_SHIFT 4
+
+// Pool allocator built on top of an arena. Freed blocks are kept in one free
+// list per size class so vectors that grow and shrink recycle their memory,
+// and vec_pool_reset releases everything at once in O(1).
+// The pool must not be moved after vec_pool_init, `allocator` points to it.
+typedef struct {
+    vec_allocator allocator;
+    vec_arena arena;
+    void *free_lists[VEC_POOL_CLASSES];
+} vec_pool;
+
+static inline size_t _vec_pool_class(size_t size) {
+    size_t cls = 0;
+    while (cls < VEC_POOL_CLASSES &&
+           ((size_t)1 << (cls + _VCPOOL_MIN_SHIFT)) < size)
+        cls++;
+    return cls;
+}
+
+static inline void *vec_pool_alloc(vec_pool *pool, size_t size) {
+    size_t cls = _vec_pool_class(size);
+    if (cls == VEC_POOL_CLASSES)
+        return vec_arena_alloc(&pool->arena, size);
+    void *ptr = pool->free_lists[cls];
+    if (ptr) {
+        pool->free_lists[cls] = *(void **)ptr;
+        return ptr;
+    }
+    return vec_arena_alloc(&pool->arena,
+                           (size_t)1 << (cls + _VCPOOL_MIN_SHIFT));
+}
+
+static inline void vec_pool_free(vec_pool *pool, void *ptr, size_t size) {
+    if (!ptr)
+        return;
+    size_t cls = _vec_pool_class(size);
+    if (cls == VEC_POOL_CLASSES) {
+        vec_arena_free(&pool->arena, ptr, size);
+        return;
+    }
+    *(void **)ptr = pool->free_lists[cls];
+    pool->free_lists[cls] = ptr;
+}
+
+static inline void *vec_pool_realloc(vec_pool *pool, void *ptr,
+                                     size_t old_size, size_t new_size) {
+    if (!ptr)
+        return vec_pool_alloc(pool, new_size);
+    size_t cls = _vec_pool_class(old_size);
+    if (cls != VEC_POOL_CLASSES && cls == _vec_pool_class(new_size))
+        return ptr;
+    void *new_ptr = vec_pool_alloc(pool, new_size);
+    if (!new_ptr)
+        return NULL;
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    vec_pool_free(pool, ptr, old_size);
+    return new_ptr;
+}
+
+// Releases every allocation at once, the arena blocks are kept for reuse.
+static inline void vec_pool_reset(vec_pool *pool) {
+    vec_arena_reset(&pool->arena);
+    memset(pool->free_lists, 0, sizeof(pool->free_lists));
+}
+
+static inline void *_vec_pool_alloc_cb(void *ctx, size_t size) {
+    return vec_pool_alloc((vec_pool *)ctx, size);
+}
+
+static inline void *_vec_pool_realloc_cb(void *ctx, void *ptr,
+                                         size_t old_size, size_t new_size) {
+    return vec_pool_realloc((vec_pool *)ctx, ptr, old_size, new_size);
+}
+
+static inline void _vec_pool_free_cb(void *ctx, void *ptr, size_t size) {
+    vec_pool_free((vec_pool *)ctx, ptr, size);
+}
+
+static inline void vec_pool_init(vec_pool *pool, size_t block_size) {
+    pool->allocator.alloc = _vec_pool_alloc_cb;
+    pool->allocator.realloc = _vec_pool_realloc_cb;
+    pool->allocator.free = _vec_pool_free_cb;
+    pool->allocator.ctx = pool;
+    vec_arena_init(&pool->arena, block_size);
+    memset(pool->free_lists, 0, sizeof(pool->free_lists));
+}
+
+static inline void vec_pool_destroy(vec_pool *pool) {
+    vec_arena_destroy(&pool->arena);
+    memset(pool->free_lists, 0, sizeof(pool->free_lists));
+}
+
+// With VEC_STATS defined before including vec.h, the vectors count their
+// allocations in a vec_stats of their type (`name_stats()`), in the global
+// vec_stats_global and in the vec_stats tagged on the current thread with
+// vec_stats_tag, if there's one. `name_stats()` is static, so every source
+// file that defines the type has its own counters. Sizes are in bytes,
+// `bytes_moved` counts the elements that had to be kept by a reallocation and
+// `peak_used` is the biggest `size` a push reached. Nothing is recorded
+// without VEC_STATS. Only the element buffers of vectors are counted:
+// segmented and concurrent vectors aren't, and neither are the scratch
+// buffers taken with VEC_MALLOC by sort, radix and parallel sort, the soa
+// sort and permute, the parallel ops, hash indexes and shared reference
+// counts, nor the headers allocated by `name_new`.
+typedef struct {
+    uint64_t allocs, reallocs, frees, shrinks;
+    uint64_t bytes_allocated, bytes_moved, bytes_released;
+    uint64_t live, peak, peak_used;
+} vec_stats;
+
+#ifdef VEC_STATS
+#if defined(__GNUC__) || defined(__clang__)
+#define _VCSTATS_ADD(field, n) __atomic_fetch_add(&(field), n, __ATOMIC_RELAXED)
+#define _VCSTATS_SUB(field, n) __atomic_fetch_sub(&(field), n, __ATOMIC_RELAXED)
+#define _VCSTATS_LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define _VCSTATS_CAS(field, old, n)                                            \
+    __atomic_compare_exchange_n(&(field), &(old), n, true, __ATOMIC_RELAXED,   \
+                                __ATOMIC_RELAXED)
+#define _VCSTATS_THREAD __thread
+__attribute__((weak)) vec_stats vec_stats_global;
+__attribute__((weak)) _VCSTATS_THREAD vec_stats *_vec_stats_tagged;
+#else
+// Like __atomic_fetch_add, these return the value before the change.
+#define _VCSTATS_ADD(field, n) (((field) += (n)) - (n))
+#define _VCSTATS_SUB(field, n) (((field) -= (n)) + (n))
+#define _VCSTATS_LOAD(field) (field)
+#define _VCSTATS_CAS(field, old, n) ((field) = (n), true)
+static vec_stats vec_stats_global;
+static vec_stats *_vec_stats_tagged;
+#endif
+
+static inline void _vec_stats_max(uint64_t *field, uint64_t n) {
+    uint64_t old = _VCSTATS_LOAD(*field);
+    while (old < n && !_VCSTATS_CAS(*field, old, n))
+        ;
+}
+
+static inline void _vec_stats_add(vec_stats *s, size_t old_bytes,
+                                  size_t new_bytes, size_t kept_bytes) {
+    if (old_bytes == 0 && new_bytes > 0) {
+        _VCSTATS_ADD(s->allocs, 1);
+        _VCSTATS_ADD(s->bytes_allocated, new_bytes);
+    } else if (new_bytes == 0 && old_bytes > 0) {
+        _VCSTATS_ADD(s->frees, 1);
+        _VCSTATS_ADD(s->bytes_released, old_bytes);
+    } else {
+        _VCSTATS_ADD(s->reallocs, 1);
+        _VCSTATS_ADD(s->bytes_moved, kept_bytes);
+        if (new_bytes > old_bytes) {
+            _VCSTATS_ADD(s->bytes_allocated, new_bytes - old_bytes);
+        } else {
+            _VCSTATS_ADD(s->shrinks, 1);
+            _VCSTATS_ADD(s->bytes_released, old_bytes - new_bytes);
+        }
+    }
+    if (new_bytes > old_bytes)
+        _vec_stats_max(&s->peak,
+                       _VCSTATS_ADD(s->live, new_bytes - old_bytes) +
+                           new_bytes - old_bytes);
+    else
+        _VCSTATS_SUB(s->live, old_bytes - new_bytes);
+}
+
+// Records a buffer of `old_bytes` becoming `new_bytes` long.
+static inline void _vec_stats_record(vec_stats *type_stats, size_t old_bytes,
+                                     size_t new_bytes, size_t kept_bytes) {
+    if (old_bytes == new_bytes)
+        return;
+    _vec_stats_add(type_stats, old_bytes, new_bytes, kept_bytes);
+    _vec_stats_add(&vec_stats_global, old_bytes, new_bytes, kept_bytes);
+    if (_vec_stats_tagged)
+        _vec_stats_add(_vec_stats_tagged, old_bytes, new_bytes, kept_bytes);
+}
+
+static inline void _vec_stats_used(vec_stats *type_stats, size_t used_bytes) {
+    _vec_stats_max(&type_stats->peak_used, used_bytes);
+    _vec_stats_max(&vec_stats_global.peak_used, used_bytes);
+    if (_vec_stats_tagged)
+        _vec_stats_max(&_vec_stats_tagged->peak_used, used_bytes);
+}
+
+// Makes the allocations of the calling thread also count in `stats` until
+// the previous tag, which is returned, is put back. NULL removes the tag.
+static inline vec_stats *vec_stats_tag(vec_stats *stats) {
+    vec_stats *previous = _vec_stats_tagged;
+    _vec_stats_tagged = stats;
+    return previous;
+}
+
+#define _VCSTATS_DEFINE(fn_name)                                               \
+    static inline vec_stats *_VCFN(fn_name, stats)(void) {                     \
+        static vec_stats stats;                                                \
+        return &stats;                                                         \
+    }
+#define _VCSTATS_REALLOC(fn_name, old_bytes, new_bytes, kept_bytes)            \
+    _vec_stats_record(_VCFN(fn_name, stats)(), old_bytes, new_bytes,           \
+                      kept_bytes)
+#define _VCSTATS_USED(fn_name, used_bytes)                                     \
+    _vec_stats_used(_VCFN(fn_name, stats)(), used_bytes)
+#else
+static inline vec_stats *vec_stats_tag(vec_stats *stats) {
+    (void)stats;
+    return NULL;
+}
+
+#define _VCSTATS_DEFINE(fn_name)
+#define _VCSTATS_REALLOC(fn_name, old_bytes, new_bytes, kept_bytes) ((void)0)
+#define _VCSTATS_USED(fn_name, used_bytes) ((void)0)
+#endif
+
+static inline void vec_stats_reset(vec_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+// Prints the counters on one line, `slack` is the part of the peak capacity
+// that was never used.
+static inline void vec_stats_dump(FILE *file, const char *label,
+                                  const vec_stats *s) {
+    double slack = s->peak ? 1.0 - (double)s->peak_used / (double)s->peak : 0;
+    fprintf(file,
+            "%s: allocs=%llu reallocs=%llu frees=%llu shrinks=%llu "
+            "allocated=%llu moved=%llu released=%llu live=%llu peak=%llu "
+            "peak_used=%llu slack=%.2f\n",
+            label, (unsigned long long)s->allocs,
+            (unsigned long long)s->reallocs, (unsigned long long)s->frees,
+            (unsigned long long)s->shrinks,
+            (unsigned long long)s->bytes_allocated,
+            (unsigned long long)s->bytes_moved,
+            (unsigned long long)s->bytes_released,
+            (unsigned long long)s->live, (unsigned long long)s->peak,
+            (unsigned long long)s->peak_used, slack < 0 ? 0 : slack);
+}
+
+#define vec_define(type, name) vec_define2(type, name, name)
+
+#define vec_define2(type, name, fn_name)                                       \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        type *data;                                                            \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+    _vec_define_unshared(name)                                                 \
+                                                                               \
+    static inline name *_VCFN(fn_name, alloc)(void) {                          \
+        return (name *)VEC_MALLOC(sizeof(name));                               \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        v->size = 0;                                                           \
+        v->capacity = reserved;                                                \
+        if (reserved == 0) {                                                   \
+            v->data = NULL;                                                    \
+            return;                                                            \
+        }                                                                      \
+        _VCSTATS_REALLOC(fn_name, 0, sizeof(type) * reserved, 0);              \
+        if (!(v->data = (type *)_vec_heap_alloc(sizeof(type) * reserved))) {   \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        _VCFN(fn_name, init_reserved)(v, 4);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity,                  \
+                         sizeof(type) * n,                                     \
+                         sizeof(type) * (v->size < n ? v->size : n));          \
+        if (n == 0) {                                                          \
+            _vec_heap_free(v->data, sizeof(type) * v->capacity);               \
+            v->data = NULL;                                                    \
+        } else if (v->data == NULL) {                                          \
+            v->data = (type *)_vec_heap_alloc(sizeof(type) * n);               \
+            if (!v->data) {                                                    \
+                perror("malloc failed");                                       \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+        } else {                                                               \
+            type *newData = (type *)_vec_heap_realloc(                         \
+                v->data, sizeof(type) * v->capacity, sizeof(type) * n);        \
+            if (!newData) {                                                    \
+                perror("realloc failed");                                      \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            v->data = newData;                                                 \
+        }                                                                      \
+        v->capacity = n;                                                       \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, take)(name * v, name * out) {            \
+        *out = *v;                                                             \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->data = NULL;                                                        \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    _vec_define_common(type, name, fn_name)
+
+// Vector whose memory comes from a vec_allocator chosen at initialization,
+// for example a vec_arena or a vec_pool. `init` and `init_reserved` use
+// vec_heap_allocator, `init_with` and `init_reserved_with` take the allocator.
+#define vec_define_alloc(type, name) vec_define_alloc2(type, name, name)
+
+#define vec_define_alloc2(type, name, fn_name)                                 \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        type *data;                                                            \
+        const vec_allocator *allocator;                                        \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+    _vec_define_unshared(name)                                                 \
+                                                                               \
+    static inline name *_VCFN(fn_name, alloc)(void) {                          \
+        return (name *)VEC_MALLOC(sizeof(name));                               \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved_with)(                     \
+        name * v, const vec_allocator *allocator, size_t reserved) {           \
+        v->size = 0;                                                           \
+        v->capacity = reserved;                                                \
+        v->allocator = allocator;                                              \
+        if (reserved == 0) {                                                   \
+            v->data = NULL;                                                    \
+            return;                                                            \
+        }                                                                      \
+        _VCSTATS_REALLOC(fn_name, 0, sizeof(type) * reserved, 0);              \
+        if (!(v->data = (type *)allocator->alloc(allocator->ctx,               \
+                                                 sizeof(type) * reserved))) {  \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_with)(                              \
+        name * v, const vec_allocator *allocator) {                            \
+        _VCFN(fn_name, init_reserved_with)(v, allocator, 4);                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        _VCFN(fn_name, init_reserved_with)(v, vec_heap_allocator(), reserved); \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        _VCFN(fn_name, init_reserved_with)(v, vec_heap_allocator(), 4);        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        const vec_allocator *allocator = v->allocator;                         \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity,                  \
+                         sizeof(type) * n,                                     \
+                         sizeof(type) * (v->size < n ? v->size : n));          \
+        if (n == 0) {                                                          \
+            allocator->free(allocator->ctx, v->data,                           \
+                            sizeof(type) * v->capacity);                       \
+            v->data = NULL;                                                    \
+        } else if (v->data == NULL) {                                          \
+            v->data = (type *)allocator->alloc(allocator->ctx,                 \
+                                               sizeof(type) * n);              \
+            if (!v->data) {                                                    \
+                perror("malloc failed");                                       \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+        } else {                                                               \
+            type *newData = (type *)allocator->realloc(                        \
+                allocator->ctx, v->data, sizeof(type) * v->capacity,           \
+                sizeof(type) * n);                                             \
+            if (!newData) {                                                    \
+                perror("realloc failed");                                      \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            v->data = newData;                                                 \
+        }                                                                      \
+        v->capacity = n;                                                       \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+    }                                                                          \
+                                                                               \
+    /* The allocators aren't thread safe, so the buffer stays here and */      \
+    /* clear_deferred clears the vector on the calling thread. */              \
+    static inline bool _VCFN(fn_name, take)(name * v, name * out) {            \
+        (void)v;                                                               \
+        (void)out;                                                             \
+        return false;                                                          \
+    }                                                                          \
+                                                                               \
+    _vec_define_common(type, name, fn_name)
+
+// Vector that keeps up to `N` elements inside the struct and only allocates
+// when it grows past that. `data` points to the inline storage until then, so
+// the struct must not be copied around while it's in use (passing it by value
+// to the functions is fine). Shrinking to `N` elements or less moves the
+// elements back inline and frees the heap buffer.
+#define vec_define_small(type, name, N) vec_define_small2(type, name, name, N)
+
+#define vec_define_small2(type, name, fn_name, N)                              \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        type *data;                                                            \
+        type inline_data[N];                                                   \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+    _vec_define_unshared(name)                                                 \
+                                                                               \
+    static inline name *_VCFN(fn_name, alloc)(void) {                          \
+        return (name *)VEC_MALLOC(sizeof(name));                               \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        if (n < (N))                                                           \
+            n = (N);                                                           \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        _VCSTATS_REALLOC(fn_name,                                              \
+                         v->capacity == (N) ? 0 : sizeof(type) * v->capacity,  \
+                         n == (N) ? 0 : sizeof(type) * n,                      \
+                         sizeof(type) * (v->size < n ? v->size : n));          \
+        if (n == (N)) {                                                        \
+            memcpy(v->inline_data, v->data,                                    \
+                   sizeof(type) * (v->size < (N) ? v->size : (N)));            \
+            _vec_heap_free(v->data, sizeof(type) * v->capacity);               \
+            v->data = v->inline_data;                                          \
+        } else if (v->capacity == (N)) {                                       \
+            type *newData = (type *)_vec_heap_alloc(sizeof(type) * n);         \
+            if (!newData) {                                                    \
+                perror("malloc failed");                                       \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            memcpy(newData, v->inline_data, sizeof(type) * v->size);           \
+            v->data = newData;                                                 \
+        } else {                                                               \
+            type *newData = (type *)_vec_heap_realloc(                         \
+                v->data, sizeof(type) * v->capacity, sizeof(type) * n);        \
+            if (!newData) {                                                    \
+                perror("realloc failed");                                      \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            v->data = newData;                                                 \
+        }                                                                      \
+        v->capacity = n;                                                       \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        v->size = 0;                                                           \
+        v->capacity = (N);                                                     \
+        v->data = v->inline_data;                                              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        _VCFN(fn_name, init)(v);                                               \
+        _VCFN(fn_name, realloc)(v, reserved);                                  \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, is_inline)(name v) {                     \
+        return v.capacity == (N);                                              \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, take)(name * v, name * out) {            \
+        *out = *v;                                                             \
+        if (v->capacity == (N)) {                                              \
+            out->data = out->inline_data;                                      \
+        } else {                                                               \
+            v->data = v->inline_data;                                          \
+            v->capacity = (N);                                                 \
+        }                                                                      \
+        v->size = 0;                                                           \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    _vec_define_common(type, name, fn_name)
+
+#ifdef _VC_HAS_MMAP
+// Files used by vec_define_mmap vectors start with this header, the elements
+// follow right after it. `size` is only written by `sync` and `close`.
+typedef struct {
+    char magic[8];
+    uint64_t elem_size, size;
+} vec_mmap_header;
+
+#define _VCMMAP_MAGIC "vec.h\x01\0"
+// Space reserved for the header, it keeps the elements 64 byte aligned.
+#define _VCMMAP_HEADER ((size_t)64)
+
+// Maps `len` bytes of `fd`, replacing the old mapping at `base` if there's one.
+static inline void *_vec_mmap_remap(void *base, size_t old_len, size_t new_len,
+                                    int fd, bool readonly) {
+    void *ptr;
+#ifdef MREMAP_MAYMOVE
+    if (base)
+        ptr = mremap(base, old_len, new_len, MREMAP_MAYMOVE);
+    else
+#endif
+    {
+        if (base)
+            munmap(base, old_len);
+        ptr = mmap(NULL, new_len, PROT_READ | PROT_WRITE,
+                   readonly ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    }
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+// Vector stored in a memory mapped file. `open` creates the file or reloads
+// the vector saved in it, growing extends the file and remaps it and
+// shrinking truncates it. `open_readonly` maps an existing file without
+// reading it, pages are loaded on first access and changes stay in memory.
+// The size is saved to the file by `sync`, which also waits for the pages to
+// be written, and by `close`. The struct starts like vec_define's so every
+// optional method works on it.
+#define vec_define_mmap(type, name) vec_define_mmap2(type, name, name)
+
+#define vec_define_mmap2(type, name, fn_name)                                  \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        type *data;                                                            \
+        int fd;                                                                \
+        bool readonly;                                                         \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+    _vec_define_unshared(name)                                                 \
+                                                                               \
+    static inline vec_mmap_header *_VCFN(fn_name, header)(name * v) {          \
+        return (vec_mmap_header *)((char *)v->data - _VCMMAP_HEADER);          \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, open_fd)(name * v, int fd,               \
+                                               bool readonly) {                \
+        struct stat st;                                                        \
+        if (fstat(fd, &st) != 0)                                               \
+            return false;                                                      \
+        size_t len = (size_t)st.st_size;                                       \
+        bool created = len == 0;                                               \
+        if (created) {                                                         \
+            if (readonly) {                                                    \
+                errno = EINVAL;                                                \
+                return false;                                                  \
+            }                                                                  \
+            len = _VCMMAP_HEADER;                                              \
+            if (ftruncate(fd, (off_t)len) != 0)                                \
+                return false;                                                  \
+        }                                                                      \
+        if (len < _VCMMAP_HEADER) {                                            \
+            errno = EINVAL;                                                    \
+            return false;                                                      \
+        }                                                                      \
+        char *base = (char *)_vec_mmap_remap(NULL, 0, len, fd, readonly);      \
+        if (!base)                                                             \
+            return false;                                                      \
+        vec_mmap_header *header = (vec_mmap_header *)base;                     \
+        if (created) {                                                         \
+            memcpy(header->magic, _VCMMAP_MAGIC, sizeof(header->magic));       \
+            header->elem_size = sizeof(type);                                  \
+            header->size = 0;                                                  \
+        } else if (memcmp(header->magic, _VCMMAP_MAGIC,                        \
+                          sizeof(header->magic)) != 0 ||                       \
+                   header->elem_size != sizeof(type)) {                        \
+            munmap(base, len);                                                 \
+            errno = EINVAL;                                                    \
+            return false;                                                      \
+        }                                                                      \
+        v->fd = fd;                                                            \
+        v->readonly = readonly;                                                \
+        v->data = (type *)(base + _VCMMAP_HEADER);                             \
+        v->capacity = (len - _VCMMAP_HEADER) / sizeof(type);                   \
+        _VCSTATS_REALLOC(fn_name, 0, sizeof(type) * v->capacity, 0);           \
+        v->size = header->size < v->capacity ? (size_t)header->size            \
+                                             : v->capacity;                    \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, open)(name * v, const char *path) {      \
+        int fd = open(path, O_RDWR | O_CREAT, 0644);                           \
+        if (fd < 0)                                                            \
+            return false;                                                      \
+        if (!_VCFN(fn_name, open_fd)(v, fd, false)) {                          \
+            close(fd);                                                         \
+            return false;                                                      \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, open_readonly)(name * v,                 \
+                                                     const char *path) {       \
+        int fd = open(path, O_RDONLY);                                         \
+        if (fd < 0)                                                            \
+            return false;                                                      \
+        if (!_VCFN(fn_name, open_fd)(v, fd, true)) {                           \
+            close(fd);                                                         \
+            return false;                                                      \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        if (v->readonly) {                                                     \
+            errno = EROFS;                                                     \
+            perror("mmap vector is read-only");                                \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity,                  \
+                         sizeof(type) * n,                                     \
+                         sizeof(type) * (v->size < n ? v->size : n));          \
+        size_t old_len = _VCMMAP_HEADER + sizeof(type) * v->capacity;          \
+        size_t new_len = _VCMMAP_HEADER + sizeof(type) * n;                    \
+        char *base = (char *)_VCFN(fn_name, header)(v);                        \
+        if (new_len > old_len && ftruncate(v->fd, (off_t)new_len) != 0) {      \
+            perror("ftruncate failed");                                        \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        if (!(base = (char *)_vec_mmap_remap(base, old_len, new_len, v->fd,    \
+                                             false))) {                        \
+            perror("mmap failed");                                             \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        if (new_len < old_len && ftruncate(v->fd, (off_t)new_len) != 0) {      \
+            perror("ftruncate failed");                                        \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        v->data = (type *)(base + _VCMMAP_HEADER);                             \
+        v->capacity = n;                                                       \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, sync)(name * v) {                        \
+        if (v->readonly)                                                       \
+            return true;                                                       \
+        _VCFN(fn_name, header)(v)->size = v->size;                             \
+        return msync(_VCFN(fn_name, header)(v),                                \
+                     _VCMMAP_HEADER + sizeof(type) * v->capacity,              \
+                     MS_SYNC) == 0;                                            \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, close)(name * v) {                       \
+        if (!v->data)                                                          \
+            return;                                                            \
+        if (!v->readonly)                                                      \
+            _VCFN(fn_name, header)(v)->size = v->size;                         \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity, 0, 0);           \
+        munmap(_VCFN(fn_name, header)(v),                                      \
+               _VCMMAP_HEADER + sizeof(type) * v->capacity);                   \
+        close(v->fd);                                                          \
+        v->data = NULL;                                                        \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->fd = -1;                                                            \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, take)(name * v, name * out) {            \
+        (void)v;                                                               \
+        (void)out;                                                             \
+        return false;                                                          \
+    }                                                                          \
+                                                                               \
+    _vec_define_common(type, name, fn_name)
+#endif // _VC_HAS_MMAP
+
+// Growable circular buffer: elements live at `data[(head + i) % capacity]`,
+// so pushing and popping at both ends is O(1) and never moves the others.
+// `linearize` rotates the elements to the start of `data` and sets `head` to
+// 0, after which the vector can be passed to the generators that read `data`
+// as a plain array (vec_define_sort, vec_define_contains, vec_define_print,
+// vec_define_free_simple). Push again only after you're done with them.
+#define vec_define_ring(type, name) vec_define_ring2(type, name, name)
+
+#define vec_define_ring2(type, name, fn_name)                                  \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        type *data;                                                            \
+        size_t head;                                                           \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+    _vec_define_unshared(name)                                                 \
+                                                                               \
+    static inline size_t _VCFN(fn_name, slot)(const name *v, size_t i) {       \
+        size_t slot = v->head + i;                                             \
+        return slot >= v->capacity ? slot - v->capacity : slot;                \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, relocate)(name * v, size_t n) {          \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity,                  \
+                         sizeof(type) * n,                                     \
+                         sizeof(type) * v->size);                              \
+        type *newData = NULL;                                                  \
+        if (n > 0 && !(newData = (type *)_vec_heap_alloc(sizeof(type) * n))) { \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        if (v->size > 0) {                                                     \
+            size_t first = v->capacity - v->head;                              \
+            if (first > v->size)                                               \
+                first = v->size;                                               \
+            memcpy(newData, v->data + v->head, sizeof(type) * first);          \
+            memcpy(newData + first, v->data, sizeof(type) * (v->size - first)); \
+        }                                                                      \
+        _vec_heap_free(v->data, sizeof(type) * v->capacity);                   \
+        v->data = newData;                                                     \
+        v->capacity = n;                                                       \
+        v->head = 0;                                                           \
+    }                                                                          \
+                                                                               \
+    /* Growing reallocates the buffer and moves the shorter of the wrapped */  \
+    /* parts into the new space, so the elements stay in order. */             \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        if (n < v->capacity || v->capacity == 0) {                             \
+            _VCFN(fn_name, relocate)(v, n);                                    \
+            return;                                                            \
+        }                                                                      \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity,                  \
+                         sizeof(type) * n, sizeof(type) * v->size);            \
+        type *newData = (type *)_vec_heap_realloc(                             \
+            v->data, sizeof(type) * v->capacity, sizeof(type) * n);            \
+        if (!newData) {                                                        \
+            perror("realloc failed");                                          \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        size_t first = v->capacity - v->head;                                  \
+        if (v->size > first) {                                                 \
+            size_t wrapped = v->size - first;                                  \
+            if (wrapped <= first && wrapped <= n - v->capacity) {              \
+                memcpy(newData + v->capacity, newData,                         \
+                       sizeof(type) * wrapped);                                \
+            } else {                                                           \
+                memmove(newData + n - first, newData + v->head,                \
+                        sizeof(type) * first);                                 \
+                v->head = n - first;                                           \
+            }                                                                  \
+        }                                                                      \
+        v->data = newData;                                                     \
+        v->capacity = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->data = NULL;                                                        \
+        v->head = 0;                                                           \
+        _VCFN(fn_name, realloc)(v, reserved);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        _VCFN(fn_name, init_reserved)(v, 4);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reserve)(name * v, size_t n) {           \
+        if (n > v->capacity)                                                   \
+            _VCFN(fn_name, realloc)(v, n);                                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, shrink)(name * v) {                      \
+        if (v->size != v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, v->size);                               \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, empty)(name v) {                         \
+        return v.size == 0;                                                    \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, push_back)(name * v, type x) {           \
+        if (v->size >= v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, _vec_grow_capacity(v->capacity));       \
+        v->data[_VCFN(fn_name, slot)(v, v->size++)] = x;                       \
+        _VCSTATS_USED(fn_name, sizeof(type) * v->size);                        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, push_front)(name * v, type x) {          \
+        if (v->size >= v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, _vec_grow_capacity(v->capacity));       \
+        v->head = v->head == 0 ? v->capacity - 1 : v->head - 1;                \
+        v->data[v->head] = x;                                                  \
+        v->size++;                                                             \
+        _VCSTATS_USED(fn_name, sizeof(type) * v->size);                        \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, pop_front)(name * v) {                   \
+        if (v->size == 0) {                                                    \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        type x = v->data[v->head];                                             \
+        v->head = _VCFN(fn_name, slot)(v, 1);                                  \
+        v->size--;                                                             \
+        return x;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, pop_back)(name * v) {                    \
+        if (v->size == 0) {                                                    \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        return v->data[_VCFN(fn_name, slot)(v, --v->size)];                    \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, front)(name v) {                        \
+        return v.size == 0 ? NULL : &v.data[v.head];                           \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, back)(name v) {                         \
+        return v.size == 0 ? NULL                                              \
+                           : &v.data[_VCFN(fn_name, slot)(&v, v.size - 1)];    \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, at)(name v, size_t i) {                  \
+        if (i >= v.size) {                                                     \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        return v.data[_VCFN(fn_name, slot)(&v, i)];                            \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set)(name * v, size_t i, type x) {       \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        v->data[_VCFN(fn_name, slot)(v, i)] = x;                               \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, take)(name * v, name * out) {            \
+        *out = *v;                                                             \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->data = NULL;                                                        \
+        v->head = 0;                                                           \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, linearize)(name * v) {                  \
+        if (v->head == 0)                                                      \
+            return v->data;                                                    \
+        if (v->head + v->size <= v->capacity) {                                \
+            memmove(v->data, v->data + v->head, sizeof(type) * v->size);       \
+            v->head = 0;                                                       \
+            return v->data;                                                    \
+        }                                                                      \
+        _VCFN(fn_name, relocate)(v, v->capacity);                              \
+        return v->data;                                                        \
+    }
+
+// Vector whose buffer can be shared by several vectors. `clone` gives another
+// vector of the same elements in O(1), the buffer is copied by the first
+// function that changes the elements or the size of a vector whose buffer is
+// shared. `refs` points to the number of vectors sharing the buffer, it is
+// only allocated by the first clone and NULL until then.
+//
+// `slice(v, i, j)` gives a view of the elements from `i` to `j` that doesn't
+// own them, so `v` must stay unchanged while it's used. Views are read like
+// any vector, changing one copies the elements into a buffer of its own that
+// must be freed like the buffer of any vector. Views have a capacity of 0.
+#define vec_define_shared(type, name) vec_define_shared2(type, name, name)
+#define vec_define_shared2(type, name, fn_name)                                \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        type *data;                                                            \
+        size_t *refs;                                                          \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+                                                                               \
+    static inline name *_VCFN(fn_name, alloc)(void) {                          \
+        return (name *)VEC_MALLOC(sizeof(name));                               \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, is_view)(const name *v) {                \
+        return v->capacity == 0 && v->data != NULL;                            \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, is_shared)(const name *v) {              \
+        return _VCFN(fn_name, is_view)(v) ||                                   \
+               (v->refs && __atomic_load_n(v->refs, __ATOMIC_ACQUIRE) > 1);    \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, release)(name * v) {                     \
+        if (!_VCFN(fn_name, is_view)(v) &&                                     \
+            (!v->refs ||                                                       \
+             __atomic_sub_fetch(v->refs, 1, __ATOMIC_ACQ_REL) == 0)) {         \
+            _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity, 0, 0);       \
+            _vec_heap_free(v->data, sizeof(type) * v->capacity);               \
+            VEC_FREE(v->refs);                                                 \
+        }                                                                      \
+        v->data = NULL;                                                        \
+        v->refs = NULL;                                                        \
+        v->capacity = 0;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, unshare)(name * v, size_t n) {           \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+        type *newData = NULL;                                                  \
+        if (n > 0) {                                                           \
+            _VCSTATS_REALLOC(fn_name, 0, sizeof(type) * n, 0);                 \
+            if (!(newData = (type *)_vec_heap_alloc(sizeof(type) * n))) {      \
+                perror("malloc failed");                                       \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            if (v->size > 0)                                                   \
+                memcpy(newData, v->data, sizeof(type) * v->size);              \
+        }                                                                      \
+        _VCFN(fn_name, release)(v);                                            \
+        v->data = newData;                                                     \
+        v->capacity = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void name##_detach(name *v) {                                \
+        if (_VCFN(fn_name, is_shared)(v))                                      \
+            _VCFN(fn_name, unshare)(                                           \
+                v, v->capacity > v->size ? v->capacity : v->size);             \
+    }                                                                          \
+                                                                               \
+    /* Only the last reference to a buffer frees its elements. */              \
+    static inline bool name##_owns_elements(const name *v) {                   \
+        return !_VCFN(fn_name, is_shared)(v);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        if (_VCFN(fn_name, is_shared)(v)) {                                    \
+            _VCFN(fn_name, unshare)(v, n);                                     \
+            return;                                                            \
+        }                                                                      \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        if (n == 0) {                                                          \
+            _VCFN(fn_name, release)(v);                                        \
+            v->size = 0;                                                       \
+            return;                                                            \
+        }                                                                      \
+        _VCSTATS_REALLOC(fn_name, sizeof(type) * v->capacity,                  \
+                         sizeof(type) * n,                                     \
+                         sizeof(type) * (v->size < n ? v->size : n));          \
+        type *newData = (type *)_vec_heap_realloc(                             \
+            v->data, sizeof(type) * v->capacity, sizeof(type) * n);            \
+        if (!newData) {                                                        \
+            perror("realloc failed");                                          \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        v->data = newData;                                                     \
+        v->capacity = n;                                                       \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->data = NULL;                                                        \
+        v->refs = NULL;                                                        \
+        _VCFN(fn_name, realloc)(v, reserved);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        _VCFN(fn_name, init_reserved)(v, 4);                                   \
+    }                                                                          \
+                                                                               \
+    static inline name _VCFN(fn_name, clone)(name * v) {                       \
+        if (v->data && !_VCFN(fn_name, is_view)(v)) {                          \
+            if (!v->refs) {                                                    \
+                if (!(v->refs = (size_t *)VEC_MALLOC(sizeof(size_t)))) {       \
+                    perror("malloc failed");                                   \
+                    exit(EXIT_FAILURE);                                        \
+                }                                                              \
+                *v->refs = 1;                                                  \
+            }                                                                  \
+            __atomic_add_fetch(v->refs, 1, __ATOMIC_RELAXED);                  \
+        }                                                                      \
+        return *v;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline name _VCFN(fn_name, slice)(name v, size_t i, size_t j) {     \
+        if (i > j || j > v.size) {                                             \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        name s = {j - i, 0, v.data ? v.data + i : NULL, NULL};                 \
+        return s;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, take)(name * v, name * out) {            \
+        if (_VCFN(fn_name, is_shared)(v))                                      \
+            return false;                                                      \
+        *out = *v;                                                             \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->data = NULL;                                                        \
+        v->refs = NULL;                                                        \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    _vec_define_common(type, name, fn_name)
+
+// Bit helpers for the bit vectors. The builtins turn into single instructions
+// when the target has them (popcnt, tzcnt), -march=native enables them.
+#if defined(__GNUC__) || defined(__clang__)
+#define _vec_popcount64(x) ((size_t)__builtin_popcountll(x))
+#define _vec_ctz64(x) ((size_t)__builtin_ctzll(x))
+#else
+static inline size_t _vec_popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (size_t)((x * 0x0101010101010101ull) >> 56);
+}
+
+static inline size_t _vec_ctz64(uint64_t x) {
+    size_t n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+#endif
+
+#define _VCBITS_WORDS(bits) (((bits) + 63) / 64)
+#define _VCBITS_MASK(i) ((uint64_t)1 << ((i) & 63))
+
+// Sets the bits from `i` to `j` to `x`.
+static inline void _vec_bits_fill(uint64_t *d, size_t i, size_t j, bool x) {
+    while (i < j && (i & 63)) {
+        d[i / 64] = (d[i / 64] & ~_VCBITS_MASK(i)) | (x ? _VCBITS_MASK(i) : 0);
+        i++;
+    }
+    if (i + 64 <= j) {
+        memset(d + i / 64, x ? 0xff : 0, sizeof(uint64_t) * ((j - i) / 64));
+        i += (j - i) & ~(size_t)63;
+    }
+    for (; i < j; i++)
+        d[i / 64] = (d[i / 64] & ~_VCBITS_MASK(i)) | (x ? _VCBITS_MASK(i) : 0);
+}
+
+static inline size_t _vec_bits_count(const uint64_t *d, size_t words) {
+    size_t a = 0, b = 0;
+    size_t i = 0;
+    for (; i + 1 < words; i += 2) {
+        a += _vec_popcount64(d[i]);
+        b += _vec_popcount64(d[i + 1]);
+    }
+    if (i < words)
+        a += _vec_popcount64(d[i]);
+    return a + b;
+}
+
+// First set bit at or after `i`, VEC_NPOS if there's none before `size`.
+static inline size_t _vec_bits_find(const uint64_t *d, size_t size, size_t i) {
+    if (i >= size)
+        return VEC_NPOS;
+    size_t w = i / 64;
+    uint64_t word = d[w] & (~(uint64_t)0 << (i & 63));
+    size_t words = _VCBITS_WORDS(size);
+    while (!word) {
+        if (++w == words)
+            return VEC_NPOS;
+        word = d[w];
+    }
+    return w * 64 + _vec_ctz64(word);
+}
+
+// Bit vector with 64 bits per word. `size` and `capacity` count bits. The
+// bits past `size` are kept at 0, so `count` and the word operations don't
+// have to mask the last word. `and`, `or` and `xor` combine two bit vectors
+// of the same size a word at a time into the first one, the loops are plain
+// enough for the compiler to vectorize.
+#define vec_define_bits(name) vec_define_bits2(name, name)
+#define vec_define_bits2(name, fn_name)                                        \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        uint64_t *data;                                                        \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+    _vec_define_unshared(name)                                                 \
+                                                                               \
+    static inline name *_VCFN(fn_name, alloc)(void) {                          \
+        return (name *)VEC_MALLOC(sizeof(name));                               \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        size_t words = _VCBITS_WORDS(n);                                       \
+        size_t old_words = v->capacity / 64;                                   \
+        if (words == old_words)                                                \
+            return;                                                            \
+        _VCSTATS_REALLOC(fn_name, sizeof(uint64_t) * old_words,                \
+                         sizeof(uint64_t) * words,                             \
+                         sizeof(uint64_t) * (old_words < words ? old_words     \
+                                                               : words));      \
+        if (words == 0) {                                                      \
+            _vec_heap_free(v->data, sizeof(uint64_t) * old_words);             \
+            v->data = NULL;                                                    \
+        } else {                                                               \
+            uint64_t *newData = (uint64_t *)(                                  \
+                v->data ? _vec_heap_realloc(v->data,                           \
+                                            sizeof(uint64_t) * old_words,      \
+                                            sizeof(uint64_t) * words)          \
+                        : _vec_heap_alloc(sizeof(uint64_t) * words));          \
+            if (!newData) {                                                    \
+                perror("realloc failed");                                      \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            if (words > old_words)                                             \
+                memset(newData + old_words, 0,                                 \
+                       sizeof(uint64_t) * (words - old_words));                \
+            v->data = newData;                                                 \
+        }                                                                      \
+        v->capacity = words * 64;                                              \
+        if (v->size > v->capacity)                                             \
+            v->size = v->capacity;                                             \
+        if (v->size & 63)                                                      \
+            v->data[v->size / 64] &= _VCBITS_MASK(v->size) - 1;                \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->data = NULL;                                                        \
+        _VCFN(fn_name, realloc)(v, reserved);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        _VCFN(fn_name, init_reserved)(v, 64);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reserve)(name * v, size_t n) {           \
+        if (n > v->capacity)                                                   \
+            _VCFN(fn_name, realloc)(v, n);                                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, shrink)(name * v) {                      \
+        _VCFN(fn_name, realloc)(v, v->size);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, clear)(name * v) {                       \
+        _VCFN(fn_name, realloc)(v, 0);                                         \
+        v->size = 0;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, empty)(name v) {                         \
+        return v.size == 0;                                                    \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, push)(name * v, bool x) {                \
+        if (v->size == v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, _vec_grow_capacity(v->capacity));       \
+        v->data[v->size / 64] |= (uint64_t)x << (v->size & 63);                \
+        v->size++;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, pop)(name * v) {                         \
+        if (v->size == 0) {                                                    \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        v->size--;                                                             \
+        bool x = (v->data[v->size / 64] & _VCBITS_MASK(v->size)) != 0;         \
+        v->data[v->size / 64] &= ~_VCBITS_MASK(v->size);                       \
+        return x;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, at)(name v, size_t i) {                  \
+        if (i >= v.size) {                                                     \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        return (v.data[i / 64] & _VCBITS_MASK(i)) != 0;                        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set)(name * v, size_t i, bool x) {       \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        v->data[i / 64] = (v->data[i / 64] & ~_VCBITS_MASK(i)) |               \
+                          ((uint64_t)x << (i & 63));                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, flip)(name * v, size_t i) {              \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        v->data[i / 64] ^= _VCBITS_MASK(i);                                    \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, resize)(name * v, size_t n,              \
+                                              bool def_val) {                  \
+        if (n > v->capacity)                                                   \
+            _VCFN(fn_name, realloc)(v, n);                                     \
+        if (n > v->size)                                                       \
+            _vec_bits_fill(v->data, v->size, n, def_val);                      \
+        else                                                                   \
+            _vec_bits_fill(v->data, n, v->size, false);                        \
+        v->size = n;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, fill)(name * v, bool x) {                \
+        _vec_bits_fill(v->data, 0, v->size, x);                                \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, count)(name v) {                       \
+        return _vec_bits_count(v.data, _VCBITS_WORDS(v.size));                 \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, find_first_set)(name v) {              \
+        return _vec_bits_find(v.data, v.size, 0);                              \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, find_next_set)(name v, size_t i) {     \
+        return _vec_bits_find(v.data, v.size, i + 1);                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, check_size)(const name *v, name other) { \
+        if (v->size != other.size) {                                           \
+            perror("vector sizes differ");                                     \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, and)(name * v, name other) {             \
+        _VCFN(fn_name, check_size)(v, other);                                  \
+        for (size_t i = 0, n = _VCBITS_WORDS(v->size); i < n; i++)             \
+            v->data[i] &= other.data[i];                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, or)(name * v, name other) {              \
+        _VCFN(fn_name, check_size)(v, other);                                  \
+        for (size_t i = 0, n = _VCBITS_WORDS(v->size); i < n; i++)             \
+            v->data[i] |= other.data[i];                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, xor)(name * v, name other) {             \
+        _VCFN(fn_name, check_size)(v, other);                                  \
+        for (size_t i = 0, n = _VCBITS_WORDS(v->size); i < n; i++)             \
+            v->data[i] ^= other.data[i];                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, not)(name * v) {                         \
+        size_t n = _VCBITS_WORDS(v->size);                                     \
+        for (size_t i = 0; i < n; i++)                                         \
+            v->data[i] = ~v->data[i];                                          \
+        if (v->size & 63)                                                      \
+            v->data[n - 1] &= _VCBITS_MASK(v->size) - 1;                       \
+    }
+
+// Layout shared by the segmented vectors: segment `k` holds `_VCSEG_FIRST << k`
+// elements, so the segment an index falls in is found with one bit scan and
+// adding a segment never moves the elements that are already stored.
+#define _VCSEG_FIRST_LOG2 4
+#define _VCSEG_FIRST ((size_t)1 << _VCSEG_FIRST_LOG2)
+#define _VCSEG_COUNT (sizeof(size_t) * 8 - _VCSEG_FIRST_LOG2)
+
+static inline size_t _vec_log2(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(unsigned long long) * 8 - 1 -
+           (size_t)__builtin_clzll((unsigned long long)x);
+#else
+    size_t r = 0;
+    while (x >>= 1)
+        r++;
+    return r;
+#endif
+}
+
+static inline size_t _vec_seg_index(size_t i) {
+    return _vec_log2(i + _VCSEG_FIRST) - _VCSEG_FIRST_LOG2;
+}
+
+static inline size_t _vec_seg_offset(size_t i, size_t seg) {
+    return i + _VCSEG_FIRST - (_VCSEG_FIRST << seg);
+}
+
+// Vector stored in segments that double in size (see _VCSEG_FIRST). Growing
+// allocates one more segment and never moves the elements, so pointers from
+// `ptr` and `back` stay valid until the element is popped. The struct is
+// large, so unlike vec_define every function takes a pointer to it.
+#define vec_define_segmented(type, name) vec_define_segmented2(type, name, name)
+
+#define vec_define_segmented2(type, name, fn_name)                             \
+    typedef struct {                                                           \
+        size_t size, capacity, segment_count;                                  \
+        type *segments[_VCSEG_COUNT];                                          \
+    } name;                                                                    \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        v->segment_count = 0;                                                  \
+        memset(v->segments, 0, sizeof(v->segments));                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reserve)(name * v, size_t n) {           \
+        while (v->capacity < n) {                                              \
+            size_t seg = v->segment_count;                                     \
+            v->segments[seg] = (type *)_vec_heap_alloc(sizeof(type) *          \
+                                                       (_VCSEG_FIRST << seg)); \
+            if (!v->segments[seg]) {                                           \
+                perror("malloc failed");                                       \
+                exit(EXIT_FAILURE);                                            \
+            }                                                                  \
+            v->capacity += _VCSEG_FIRST << seg;                                \
+            v->segment_count++;                                                \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, shrink)(name * v) {                      \
+        size_t keep = v->size == 0 ? 0 : _vec_seg_index(v->size - 1) + 1;      \
+        while (v->segment_count > keep) {                                      \
+            size_t seg = --v->segment_count;                                   \
+            _vec_heap_free(v->segments[seg],                                   \
+                           sizeof(type) * (_VCSEG_FIRST << seg));              \
+            v->segments[seg] = NULL;                                           \
+            v->capacity -= _VCSEG_FIRST << seg;                                \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, clear)(name * v) {                       \
+        v->size = 0;                                                           \
+        _VCFN(fn_name, shrink)(v);                                             \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, ptr)(const name *v, size_t i) {         \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        size_t seg = _vec_seg_index(i);                                        \
+        return &v->segments[seg][_vec_seg_offset(i, seg)];                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, push)(name * v, type x) {                \
+        if (v->size == v->capacity)                                            \
+            _VCFN(fn_name, reserve)(v, v->size + 1);                           \
+        size_t seg = _vec_seg_index(v->size);                                  \
+        v->segments[seg][_vec_seg_offset(v->size, seg)] = x;                   \
+        v->size++;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, pop)(name * v) {                         \
+        if (v->size == 0) {                                                    \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        type x = *_VCFN(fn_name, ptr)(v, v->size - 1);                         \
+        v->size--;                                                             \
+        return x;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, back)(const name *v) {                  \
+        return v->size == 0 ? NULL : _VCFN(fn_name, ptr)(v, v->size - 1);      \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, empty)(const name *v) {                  \
+        return v->size == 0;                                                   \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, at)(const name *v, size_t i) {           \
+        return *_VCFN(fn_name, ptr)(v, i);                                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set)(name * v, size_t i, type x) {       \
+        *_VCFN(fn_name, ptr)(v, i) = x;                                        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reverse)(name * v) {                     \
+        for (size_t i = 0; i < v->size / 2; i++) {                             \
+            type *a = _VCFN(fn_name, ptr)(v, i);                               \
+            type *b = _VCFN(fn_name, ptr)(v, v->size - 1 - i);                 \
+            type tmp = *a;                                                     \
+            *a = *b;                                                           \
+            *b = tmp;                                                          \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, copy_to)(const name *v, type *out) {     \
+        for (size_t seg = 0, i = 0; i < v->size; seg++) {                      \
+            size_t n = _VCSEG_FIRST << seg;                                    \
+            if (n > v->size - i)                                               \
+                n = v->size - i;                                               \
+            memcpy(out + i, v->segments[seg], sizeof(type) * n);               \
+            i += n;                                                            \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, copy_from)(name * v, const type *in) {   \
+        for (size_t seg = 0, i = 0; i < v->size; seg++) {                      \
+            size_t n = _VCSEG_FIRST << seg;                                    \
+            if (n > v->size - i)                                               \
+                n = v->size - i;                                               \
+            memcpy(v->segments[seg], in + i, sizeof(type) * n);                \
+            i += n;                                                            \
+        }                                                                      \
+    }
+
+// Optional methods for segmented vectors, same expressions as
+// vec_define_contains and vec_define_sort. Sorting copies the elements to a
+// temporary contiguous buffer, sorts it and copies them back in place.
+#define vec_define_segmented_contains(type, name, eq_st)                       \
+    vec_define_segmented_contains2(type, name, name, eq_st)
+#define vec_define_segmented_contains2(type, name, fn_name, eq_st)             \
+    static inline size_t _VCFN(fn_name, find_index)(const name *v, type b) {   \
+        for (size_t seg = 0, i = 0; i < v->size; seg++) {                      \
+            size_t n = _VCSEG_FIRST << seg;                                    \
+            if (n > v->size - i)                                               \
+                n = v->size - i;                                               \
+            const type *s = v->segments[seg];                                  \
+            for (size_t k = 0; k < n; k++) {                                   \
+                type a = s[k];                                                 \
+                if (eq_st)                                                     \
+                    return i + k;                                              \
+            }                                                                  \
+            i += n;                                                            \
+        }                                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, contains)(const name *v, type b) {       \
+        return _VCFN(fn_name, find_index)(v, b) != VEC_NPOS;                   \
+    }
+
+#define vec_define_segmented_sort(type, name, comp_st)                         \
+    vec_define_segmented_sort2(type, name, name, comp_st)
+#define vec_define_segmented_sort2(type, name, fn_name, comp_st)               \
+    _vec_define_sort_cmp(type, fn_name, comp_st)                               \
+    _vec_define_sort_engine(type, fn_name, sort_range, sort_less)              \
+    _vec_define_sort_engine(type, fn_name, sort_range_rev, sort_less_rev)      \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_with)(                              \
+        name * v, void (*sort_range)(type *, size_t)) {                        \
+        if (v->size <= _VCSEG_FIRST) {                                         \
+            if (v->size > 0)                                                   \
+                sort_range(v->segments[0], v->size);                           \
+            return;                                                            \
+        }                                                                      \
+        type *tmp = (type *)VEC_MALLOC(sizeof(type) * v->size);                \
+        if (!tmp) {                                                            \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        _VCFN(fn_name, copy_to)(v, tmp);                                       \
+        sort_range(tmp, v->size);                                              \
+        _VCFN(fn_name, copy_from)(v, tmp);                                     \
+        VEC_FREE(tmp);                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort)(name * v) {                        \
+        _VCFN(fn_name, sort_with)(v, _VCFN(fn_name, sort_range));              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_reversed)(name * v) {               \
+        _VCFN(fn_name, sort_with)(v, _VCFN(fn_name, sort_range_rev));          \
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+// Vector that many threads can push to at the same time without locks. A push
+// claims its slot with an atomic fetch-add and writes it, segments are
+// allocated on demand and published with a compare-and-swap, and since they
+// never move a slot stays valid while others push. `size` counts the claimed
+// slots, not the written ones, so `at` and `flatten` may only run once every
+// producer is done (joined), and `slot` only on slots the calling thread
+// claimed. `flatten` appends the elements to a regular vector of type
+// `vec_name` with functions prefixed by `vec_fn_name`.
+#define vec_define_concurrent(type, name, vec_name)                            \
+    vec_define_concurrent2(type, name, name, vec_name, vec_name)
+
+#define vec_define_concurrent2(type, name, fn_name, vec_name, vec_fn_name)     \
+    typedef struct {                                                           \
+        size_t size;                                                           \
+        type *segments[_VCSEG_COUNT];                                          \
+    } name;                                                                    \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        v->size = 0;                                                           \
+        memset(v->segments, 0, sizeof(v->segments));                           \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, segment)(name * v, size_t seg) {        \
+        type *s = __atomic_load_n(&v->segments[seg], __ATOMIC_ACQUIRE);        \
+        if (s)                                                                 \
+            return s;                                                          \
+        type *fresh =                                                          \
+            (type *)_vec_heap_alloc(sizeof(type) * (_VCSEG_FIRST << seg));     \
+        if (!fresh) {                                                          \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        if (__atomic_compare_exchange_n(&v->segments[seg], &s, fresh, false,   \
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))   \
+            return fresh;                                                      \
+        _vec_heap_free(fresh, sizeof(type) * (_VCSEG_FIRST << seg));           \
+        return s;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, claim)(name * v, size_t n) {           \
+        size_t i = __atomic_fetch_add(&v->size, n, __ATOMIC_RELAXED);          \
+        if (n == 0)                                                            \
+            return i;                                                          \
+        size_t last = _vec_seg_index(i + n - 1);                               \
+        for (size_t seg = _vec_seg_index(i); seg <= last; seg++)               \
+            _VCFN(fn_name, segment)(v, seg);                                   \
+        if (_vec_seg_offset(i, _vec_seg_index(i)) == 0 &&                      \
+            last + 1 < _VCSEG_COUNT)                                           \
+            _VCFN(fn_name, segment)(v, last + 1);                              \
+        return i;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, slot)(name * v, size_t i) {             \
+        size_t seg = _vec_seg_index(i);                                        \
+        return &__atomic_load_n(&v->segments[seg],                             \
+                                __ATOMIC_ACQUIRE)[_vec_seg_offset(i, seg)];    \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, push)(name * v, type x) {              \
+        size_t i = _VCFN(fn_name, claim)(v, 1);                                \
+        *_VCFN(fn_name, slot)(v, i) = x;                                       \
+        return i;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, at)(name * v, size_t i) {                \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        return *_VCFN(fn_name, slot)(v, i);                                    \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, flatten)(name * v, vec_name * out) {     \
+        size_t size = v->size;                                                 \
+        _VCFN(vec_fn_name, reserve)(out, out->size + size);                    \
+        for (size_t seg = 0, i = 0; i < size; seg++) {                         \
+            size_t n = _VCSEG_FIRST << seg;                                    \
+            if (n > size - i)                                                  \
+                n = size - i;                                                  \
+            memcpy(out->data + out->size, v->segments[seg], sizeof(type) * n); \
+            out->size += n;                                                    \
+            i += n;                                                            \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, clear)(name * v) {                       \
+        for (size_t seg = 0; seg < _VCSEG_COUNT; seg++) {                      \
+            if (v->segments[seg])                                              \
+                _vec_heap_free(v->segments[seg],                               \
+                               sizeof(type) * (_VCSEG_FIRST << seg));          \
+            v->segments[seg] = NULL;                                           \
+        }                                                                      \
+        v->size = 0;                                                           \
+    }
+#endif
+
+// Helpers to walk the `(type, field)` pairs given to vec_define_soa. Each pair
+// is passed to `m` along with `ctx`, which is `(name, fn_name)`.
+#define _VCSOA_T(type, field) type
+#define _VCSOA_F(type, field) field
+#define _VCSOA_TYPE(p) _VCSOA_T p
+#define _VCSOA_FIELD(p) _VCSOA_F p
+#define _VCSOA_N(name, fn_name) name
+#define _VCSOA_FN_NAME(name, fn_name) fn_name
+#define _VCSOA_NAME(ctx) _VCSOA_N ctx
+#define _VCSOA_FN(ctx, op) _VCSOA_FN_(_VCSOA_FN_NAME ctx, op)
+#define _VCSOA_FN_(fn_name, op) _VCFN(fn_name, op)
+#define _VCSOA_CAT(a, b) _VCSOA_CAT_(a, b)
+#define _VCSOA_CAT_(a, b) a##b
+#define _VCSOA_NARGS(...)                                                      \
+    _VCSOA_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4,   \
+                  3, 2, 1, 0)
+#define _VCSOA_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13,  \
+                      _14, _15, _16, n, ...)                                   \
+    n
+#define _VCSOA_EACH(m, ctx, ...)                                               \
+    _VCSOA_CAT(_VCSOA_EACH_, _VCSOA_NARGS(__VA_ARGS__))(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_1(m, ctx, p) m(ctx, p)
+#define _VCSOA_EACH_2(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_1(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_3(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_2(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_4(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_3(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_5(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_4(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_6(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_5(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_7(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_6(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_8(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_7(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_9(m, ctx, p, ...) m(ctx, p) _VCSOA_EACH_8(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_10(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_9(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_11(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_10(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_12(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_11(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_13(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_12(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_14(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_13(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_15(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_14(m, ctx, __VA_ARGS__)
+#define _VCSOA_EACH_16(m, ctx, p, ...)                                         \
+    m(ctx, p) _VCSOA_EACH_15(m, ctx, __VA_ARGS__)
+
+// Every column of a vec_define_soa vector is aligned to this many bytes.
+#define _VCSOA_ALIGN 64
+
+// Moves a column to a new aligned buffer that holds `n` elements.
+static inline void _vec_soa_realloc(void **column, size_t elem_size,
+                                    size_t size, size_t n) {
+    void *new_column = NULL;
+    if (n > 0) {
+        size_t bytes = elem_size * n;
+        bytes = (bytes + _VCSOA_ALIGN - 1) & ~(size_t)(_VCSOA_ALIGN - 1);
+        if (!(new_column = aligned_alloc(_VCSOA_ALIGN, bytes))) {
+            perror("malloc failed");
+            exit(EXIT_FAILURE);
+        }
+        if (*column)
+            memcpy(new_column, *column, elem_size * (size < n ? size : n));
+    }
+    free(*column);
+    *column = new_column;
+}
+
+// Applies `perm` to a column: element `i` becomes the old element `perm[i]`.
+static inline void _vec_soa_permute(void *column, size_t elem_size,
+                                    size_t size, const size_t *perm,
+                                    void *tmp) {
+    for (size_t i = 0; i < size; i++)
+        memcpy((char *)tmp + i * elem_size,
+               (const char *)column + perm[i] * elem_size, elem_size);
+    memcpy(column, tmp, elem_size * size);
+}
+
+#define _VCSOA_RECORD_MEMBER(ctx, p) _VCSOA_TYPE(p) _VCSOA_FIELD(p);
+#define _VCSOA_MEMBER(ctx, p) _VCSOA_TYPE(p) * _VCSOA_FIELD(p);
+#define _VCSOA_NULL(ctx, p) v->_VCSOA_FIELD(p) = NULL;
+#define _VCSOA_REALLOC(ctx, p)                                                 \
+    _VCSTATS_REALLOC(_VCSOA_FN_NAME ctx, sizeof(_VCSOA_TYPE(p)) * v->capacity, \
+                     sizeof(_VCSOA_TYPE(p)) * n,                               \
+                     sizeof(_VCSOA_TYPE(p)) * (v->size < n ? v->size : n));    \
+    _vec_soa_realloc((void **)&v->_VCSOA_FIELD(p), sizeof(_VCSOA_TYPE(p)),     \
+                     v->size, n);
+// Bytes taken by `n` records, summed over the columns.
+#define _VCSOA_ROW_SIZE(ctx, p) +sizeof(_VCSOA_TYPE(p))
+#define _VCSOA_BYTES(ctx, n, ...)                                              \
+    ((n) * (0 _VCSOA_EACH(_VCSOA_ROW_SIZE, ctx, __VA_ARGS__)))
+#define _VCSOA_PUSH(ctx, p) v->_VCSOA_FIELD(p)[v->size] = r._VCSOA_FIELD(p);
+#define _VCSOA_GET(ctx, p) r._VCSOA_FIELD(p) = v->_VCSOA_FIELD(p)[i];
+#define _VCSOA_SET(ctx, p) v->_VCSOA_FIELD(p)[i] = r._VCSOA_FIELD(p);
+#define _VCSOA_MAX_SIZE(ctx, p)                                                \
+    if (sizeof(_VCSOA_TYPE(p)) > elem_size)                                    \
+        elem_size = sizeof(_VCSOA_TYPE(p));
+#define _VCSOA_PERMUTE(ctx, p)                                                 \
+    _vec_soa_permute(v->_VCSOA_FIELD(p), sizeof(_VCSOA_TYPE(p)), v->size,      \
+                     perm, tmp);
+#define _VCSOA_ACCESSOR(ctx, p)                                                \
+    static inline _VCSOA_TYPE(p) *                                             \
+        _VCSOA_FN(ctx, _VCSOA_FIELD(p))(const _VCSOA_NAME(ctx) * v) {          \
+        return v->_VCSOA_FIELD(p);                                             \
+    }
+
+// Structure of arrays vector: `vec_define_soa(name, (type1, field1), ...)`
+// keeps one aligned array per field (up to 16), all sharing the same size and
+// capacity, so a scan over one field only touches that field's memory. Whole
+// records go in and out as `name_record`, and `name_field(&v)` gives the array
+// of a field. Every function takes a pointer to the vector. VEC_STATS counts
+// every column as an allocation of its own.
+#define vec_define_soa(name, ...) vec_define_soa2(name, name, __VA_ARGS__)
+
+#define vec_define_soa2(name, fn_name, ...)                                    \
+    typedef struct {                                                           \
+        _VCSOA_EACH(_VCSOA_RECORD_MEMBER, (name, fn_name), __VA_ARGS__)        \
+    } name##_record;                                                           \
+                                                                               \
+    typedef struct {                                                           \
+        size_t size, capacity;                                                 \
+        _VCSOA_EACH(_VCSOA_MEMBER, (name, fn_name), __VA_ARGS__)               \
+    } name;                                                                    \
+    _VCSTATS_DEFINE(fn_name)                                                   \
+                                                                               \
+    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
+        if (n == v->capacity)                                                  \
+            return;                                                            \
+        _VCSOA_EACH(_VCSOA_REALLOC, (name, fn_name), __VA_ARGS__)              \
+        v->capacity = n;                                                       \
+        if (v->size > n)                                                       \
+            v->size = n;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
+                                                     size_t reserved) {        \
+        v->size = 0;                                                           \
+        v->capacity = 0;                                                       \
+        _VCSOA_EACH(_VCSOA_NULL, (name, fn_name), __VA_ARGS__)                 \
+        _VCFN(fn_name, realloc)(v, reserved);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, init)(name * v) {                        \
+        _VCFN(fn_name, init_reserved)(v, 4);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reserve)(name * v, size_t n) {           \
+        if (n > v->capacity)                                                   \
+            _VCFN(fn_name, realloc)(v, n);                                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, shrink)(name * v) {                      \
+        _VCFN(fn_name, realloc)(v, v->size);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, clear)(name * v) {                       \
+        _VCFN(fn_name, realloc)(v, 0);                                         \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, empty)(const name *v) {                  \
+        return v->size == 0;                                                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, push)(name * v, name##_record r) {       \
+        if (v->size >= v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, _vec_grow_capacity(v->capacity));       \
+        _VCSOA_EACH(_VCSOA_PUSH, (name, fn_name), __VA_ARGS__)                 \
+        v->size++;                                                             \
+        _VCSTATS_USED(fn_name,                                                 \
+                      _VCSOA_BYTES((name, fn_name), v->size, __VA_ARGS__));    \
+    }                                                                          \
+                                                                               \
+    static inline name##_record _VCFN(fn_name, at)(const name *v, size_t i) {  \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        name##_record r;                                                       \
+        _VCSOA_EACH(_VCSOA_GET, (name, fn_name), __VA_ARGS__)                  \
+        return r;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set)(name * v, size_t i,                 \
+                                           name##_record r) {                  \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        _VCSOA_EACH(_VCSOA_SET, (name, fn_name), __VA_ARGS__)                  \
+    }                                                                          \
+                                                                               \
+    static inline name##_record _VCFN(fn_name, pop)(name * v) {                \
+        if (v->size == 0) {                                                    \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        name##_record r = _VCFN(fn_name, at)(v, v->size - 1);                  \
+        v->size--;                                                             \
+        return r;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, permute)(name * v, const size_t *perm) { \
+        size_t elem_size = 0;                                                  \
+        _VCSOA_EACH(_VCSOA_MAX_SIZE, (name, fn_name), __VA_ARGS__)             \
+        void *tmp = VEC_MALLOC(elem_size * (v->size ? v->size : 1));           \
+        if (!tmp) {                                                            \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        _VCSOA_EACH(_VCSOA_PERMUTE, (name, fn_name), __VA_ARGS__)              \
+        VEC_FREE(tmp);                                                         \
+    }                                                                          \
+                                                                               \
+    _VCSOA_EACH(_VCSOA_ACCESSOR, (name, fn_name), __VA_ARGS__)
+
+// Sorts every column of a vec_define_soa vector by one field. `comp_st` works
+// like vec_define_sort's, `a` and `b` being values of the field. The sort is
+// stable. Generates `name_sort_by_field` and `name_sort_by_field_reversed`.
+#define vec_define_soa_sort(name, type, field, comp_st)                        \
+    vec_define_soa_sort2(name, name, type, field, comp_st)
+#define vec_define_soa_sort2(name, fn_name, type, field, comp_st)              \
+    typedef struct {                                                           \
+        type key;                                                              \
+        size_t index;                                                          \
+    } fn_name##_##field##_sort_pair;                                           \
+                                                                               \
+    static inline int _VCFN(fn_name##_##field, sort_cmp)(                      \
+        const fn_name##_##field##_sort_pair *a_ptr,                            \
+        const fn_name##_##field##_sort_pair *b_ptr) {                          \
+        const type a = a_ptr->key;                                             \
+        const type b = b_ptr->key;                                             \
+        return (comp_st);                                                      \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name##_##field, sort_less)(                    \
+        const fn_name##_##field##_sort_pair *x,                                \
+        const fn_name##_##field##_sort_pair *y) {                              \
+        int c = _VCFN(fn_name##_##field, sort_cmp)(x, y);                      \
+        return c < 0 || (c == 0 && x->index < y->index);                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name##_##field, sort_less_rev)(                \
+        const fn_name##_##field##_sort_pair *x,                                \
+        const fn_name##_##field##_sort_pair *y) {                              \
+        int c = _VCFN(fn_name##_##field, sort_cmp)(y, x);                      \
+        return c < 0 || (c == 0 && x->index < y->index);                       \
+    }                                                                          \
+                                                                               \
+    _vec_define_sort_engine(fn_name##_##field##_sort_pair, fn_name##_##field,  \
+                            sort_range, sort_less)                             \
+    _vec_define_sort_engine(fn_name##_##field##_sort_pair, fn_name##_##field,  \
+                            sort_range_rev, sort_less_rev)                     \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_by_##field##_with)(                 \
+        name * v,                                                              \
+        void (*sort_range)(fn_name##_##field##_sort_pair *, size_t)) {         \
+        if (v->size < 2)                                                       \
+            return;                                                            \
+        fn_name##_##field##_sort_pair *pairs =                                 \
+            (fn_name##_##field##_sort_pair *)VEC_MALLOC(                       \
+                sizeof(fn_name##_##field##_sort_pair) * v->size);              \
+        size_t *perm = (size_t *)VEC_MALLOC(sizeof(size_t) * v->size);         \
+        if (!pairs || !perm) {                                                 \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        for (size_t i = 0; i < v->size; i++) {                                 \
+            pairs[i].key = v->field[i];                                        \
+            pairs[i].index = i;                                                \
+        }                                                                      \
+        sort_range(pairs, v->size);                                            \
+        for (size_t i = 0; i < v->size; i++)                                   \
+            perm[i] = pairs[i].index;                                          \
+        VEC_FREE(pairs);                                                       \
+        _VCFN(fn_name, permute)(v, perm);                                      \
+        VEC_FREE(perm);                                                        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_by_##field)(name * v) {             \
+        _VCFN(fn_name, sort_by_##field##_with)(                                \
+            v, _VCFN(fn_name##_##field, sort_range));                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_by_##field##_reversed)(name * v) {  \
+        _VCFN(fn_name, sort_by_##field##_with)(                                \
+            v, _VCFN(fn_name##_##field, sort_range_rev));                      \
+    }
+
+// Searches a single field of a vec_define_soa vector, `eq_st` works like
+// vec_define_contains's. Generates `name_find_field`, which only reads the
+// field's array and returns the index of the first match or VEC_NPOS.
+#define vec_define_soa_find(name, type, field, eq_st)                          \
+    vec_define_soa_find2(name, name, type, field, eq_st)
+#define vec_define_soa_find2(name, fn_name, type, field, eq_st)                \
+    static inline size_t _VCFN(fn_name, find_##field)(const name *v, type b) { \
+        const type *column = v->field;                                         \
+        for (size_t i = 0; i < v->size; i++) {                                 \
+            type a = column[i];                                                \
+            if (eq_st)                                                         \
+                return i;                                                      \
+        }                                                                      \
+        return VEC_NPOS;                                                       \
+    }
+
+// Functions shared by every vector layout that starts with the
+// `size, capacity, data` fields and provides a `realloc` function.
+// Every storage defines `name_detach`, which gives the vector a buffer of its
+// own before its elements are changed, and `name_owns_elements`, which tells
+// vec_define_free whether it may free the elements. They are named after the
+// vector type, not `fn_name`, so the generators below work with any prefix.
+// Storage without shared buffers has nothing to do and owns its elements.
+#define _vec_define_unshared(name)                                             \
+    static inline void name##_detach(name *v) { (void)v; }                     \
+                                                                               \
+    static inline bool name##_owns_elements(const name *v) {                   \
+        (void)v;                                                               \
+        return true;                                                           \
+    }
+
+#define _vec_define_common(type, name, fn_name)                                \
+    static inline void _VCFN(fn_name, push)(name * v, type x) {                \
+        name##_detach(v);                                                      \
+        if (v->size >= v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, _vec_grow_capacity(v->capacity));       \
+        v->data[v->size++] = x;                                                \
+        _VCSTATS_USED(fn_name, sizeof(type) * v->size);                        \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, pop)(name * v) {                         \
+        return v->data[v->size == 0 ? 0 : --v->size];                          \
+    }                                                                          \
+                                                                               \
+    static inline type *_VCFN(fn_name, back)(name v) {                         \
+        return v.size == 0 ? NULL : &v.data[v.size - 1];                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, empty)(name v) {                         \
+        return v.size == 0;                                                    \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, at)(name v, size_t i) {                  \
+        if (i >= v.size) {                                                     \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        return v.data[i];                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set)(name * v, size_t i, type x) {       \
+        name##_detach(v);                                                      \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        v->data[i] = x;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, shrink)(name * v) {                      \
+        if (v->size != v->capacity)                                            \
+            _VCFN(fn_name, realloc)(v, v->size);                               \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reserve)(name * v, size_t n) {           \
+        if (n > v->capacity)                                                   \
+            _VCFN(fn_name, realloc)(v, n);                                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reverse)(name * v) {                     \
+        name##_detach(v);                                                      \
+        for (size_t i = 0; i < v->size / 2; i++) {                             \
+            type tmp = v->data[i];                                             \
+            v->data[i] = v->data[v->size - 1 - i];                             \
+            v->data[v->size - 1 - i] = tmp;                                    \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, grow)(name * v, size_t n) {              \
+        name##_detach(v);                                                      \
+        if (v->size + n <= v->capacity)                                        \
+            return;                                                            \
+        size_t capacity = _vec_grow_capacity(v->capacity);                     \
+        _VCFN(fn_name, realloc)(                                               \
+            v, capacity < v->size + n ? v->size + n : capacity);               \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, append_n)(name * v, const type *items,   \
+                                                size_t n) {                    \
+        if (n == 0)                                                            \
+            return;                                                            \
+        /* `items` may point into the buffer that grow moves. */               \
+        if (_vec_aliases(items, v->data, sizeof(type) * v->size)) {            \
+            size_t at = (size_t)(items - v->data);                             \
+            _VCFN(fn_name, grow)(v, n);                                        \
+            items = v->data + at;                                              \
+        } else {                                                               \
+            _VCFN(fn_name, grow)(v, n);                                        \
+        }                                                                      \
+        memcpy(v->data + v->size, items, sizeof(type) * n);                    \
+        v->size += n;                                                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, extend)(name * v, name other) {          \
+        _VCFN(fn_name, append_n)(v, other.data, other.size);                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, insert_n)(name * v, size_t i,            \
+                                                const type *items, size_t n) { \
+        if (i > v->size) {                                                     \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        if (n == 0)                                                            \
+            return;                                                            \
+        if (!_vec_aliases(items, v->data, sizeof(type) * v->size)) {           \
+            _VCFN(fn_name, grow)(v, n);                                        \
+            memmove(v->data + i + n, v->data + i,                              \
+                    sizeof(type) * (v->size - i));                             \
+            memcpy(v->data + i, items, sizeof(type) * n);                      \
+            v->size += n;                                                      \
+            return;                                                            \
+        }                                                                      \
+        /* The source is inside the vector: the part before `i` stays */       \
+        /* where it is, the rest moves `n` slots right with the tail. */       \
+        size_t at = (size_t)(items - v->data);                                 \
+        size_t left = at < i ? (i - at < n ? i - at : n) : 0;                  \
+        _VCFN(fn_name, grow)(v, n);                                            \
+        memmove(v->data + i + n, v->data + i, sizeof(type) * (v->size - i));   \
+        memcpy(v->data + i, v->data + at, sizeof(type) * left);                \
+        memcpy(v->data + i + left, v->data + at + left + n,                    \
+               sizeof(type) * (n - left));                                     \
+        v->size += n;                                                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, erase_range)(name * v, size_t i,         \
+                                                   size_t j) {                 \
+        name##_detach(v);                                                      \
+        if (i > j || j > v->size) {                                            \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        memmove(v->data + i, v->data + j, sizeof(type) * (v->size - j));       \
+        v->size -= j - i;                                                      \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, swap_remove)(name * v, size_t i) {       \
+        name##_detach(v);                                                      \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        type x = v->data[i];                                                   \
+        v->data[i] = v->data[--v->size];                                       \
+        return x;                                                              \
+    }
+
+// Linear search with `eq_st`, which compares the element `a` with the searched
+// value `b`. Besides `name_contains` this generates `name_find_index` and
+// `name_find_last`, which return VEC_NPOS when nothing matches, and
+// `name_count`, so those names can't be used by other functions.
+#define vec_define_contains(type, name, eq_st)                                 \
+    vec_define_contains2(type, name, name, eq_st)
+#define vec_define_contains2(type, name, fn_name, eq_st)                       \
+    static inline bool _VCFN(fn_name, contains)(name v, type b) {              \
+        for (size_t i = 0; i < v.size; i++) {                                  \
+            type a = v.data[i];                                                \
+            if (eq_st)                                                         \
+                return true;                                                   \
+        }                                                                      \
+        return false;                                                          \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, find_index)(name v, type b) {          \
+        for (size_t i = 0; i < v.size; i++) {                                  \
+            type a = v.data[i];                                                \
+            if (eq_st)                                                         \
+                return i;                                                      \
+        }                                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, find_last)(name v, type b) {           \
+        for (size_t i = v.size; i-- > 0;) {                                    \
+            type a = v.data[i];                                                \
+            if (eq_st)                                                         \
+                return i;                                                      \
+        }                                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, count)(name v, type b) {               \
+        size_t count = 0;                                                      \
+        for (size_t i = 0; i < v.size; i++) {                                  \
+            type a = v.data[i];                                                \
+            if (eq_st)                                                         \
+                count++;                                                       \
+        }                                                                      \
+        return count;                                                          \
+    }
+
+// Search kernels for primitive vectors, one set per element width. With AVX2
+// or SSE2 enabled at compile time they compare a whole register of elements
+// at once and turn the result into a bit mask with one bit per byte, so a
+// match is located with a single bit scan. Integers are compared by their bit
+// pattern and floats with ==, exactly like the scalar loop would.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define _VCSIMD_BYTES 32
+#define _VCSIMD_VT_i8 __m256i
+#define _VCSIMD_VT_i16 __m256i
+#define _VCSIMD_VT_i32 __m256i
+#define _VCSIMD_VT_i64 __m256i
+#define _VCSIMD_VT_f32 __m256
+#define _VCSIMD_VT_f64 __m256d
+#define _VCSIMD_SPLAT_i8(x) _mm256_set1_epi8((char)(x))
+#define _VCSIMD_SPLAT_i16(x) _mm256_set1_epi16((short)(x))
+#define _VCSIMD_SPLAT_i32(x) _mm256_set1_epi32((int)(x))
+#define _VCSIMD_SPLAT_i64(x) _mm256_set1_epi64x((long long)(x))
+#define _VCSIMD_SPLAT_f32(x) _mm256_set1_ps(x)
+#define _VCSIMD_SPLAT_f64(x) _mm256_set1_pd(x)
+#define _VCSIMD_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define _VCSIMD_MASK(x) ((uint32_t)_mm256_movemask_epi8(x))
+#define _VCSIMD_EQ_i8(p, nv) _VCSIMD_MASK(_mm256_cmpeq_epi8(_VCSIMD_LOAD(p), nv))
+#define _VCSIMD_EQ_i16(p, nv)                                                  \
+    _VCSIMD_MASK(_mm256_cmpeq_epi16(_VCSIMD_LOAD(p), nv))
+#define _VCSIMD_EQ_i32(p, nv)                                                  \
+    _VCSIMD_MASK(_mm256_cmpeq_epi32(_VCSIMD_LOAD(p), nv))
+#define _VCSIMD_EQ_i64(p, nv)                                                  \
+    _VCSIMD_MASK(_mm256_cmpeq_epi64(_VCSIMD_LOAD(p), nv))
+#define _VCSIMD_EQ_f32(p, nv)                                                  \
+    _VCSIMD_MASK(_mm256_castps_si256(                                          \
+        _mm256_cmp_ps(_mm256_loadu_ps((const float *)(p)), nv, _CMP_EQ_OQ)))
+#define _VCSIMD_EQ_f64(p, nv)                                                  \
+    _VCSIMD_MASK(_mm256_castpd_si256(                                          \
+        _mm256_cmp_pd(_mm256_loadu_pd((const double *)(p)), nv, _CMP_EQ_OQ)))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define _VCSIMD_BYTES 16
+#define _VCSIMD_VT_i8 __m128i
+#define _VCSIMD_VT_i16 __m128i
+#define _VCSIMD_VT_i32 __m128i
+#define _VCSIMD_VT_i64 __m128i
+#define _VCSIMD_VT_f32 __m128
+#define _VCSIMD_VT_f64 __m128d
+#define _VCSIMD_SPLAT_i8(x) _mm_set1_epi8((char)(x))
+#define _VCSIMD_SPLAT_i16(x) _mm_set1_epi16((short)(x))
+#define _VCSIMD_SPLAT_i32(x) _mm_set1_epi32((int)(x))
+#define _VCSIMD_SPLAT_i64(x) _mm_set1_epi64x((long long)(x))
+#define _VCSIMD_SPLAT_f32(x) _mm_set1_ps(x)
+#define _VCSIMD_SPLAT_f64(x) _mm_set1_pd(x)
+#define _VCSIMD_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define _VCSIMD_MASK(x) ((uint32_t)_mm_movemask_epi8(x))
+#define _VCSIMD_EQ_i8(p, nv) _VCSIMD_MASK(_mm_cmpeq_epi8(_VCSIMD_LOAD(p), nv))
+#define _VCSIMD_EQ_i16(p, nv) _VCSIMD_MASK(_mm_cmpeq_epi16(_VCSIMD_LOAD(p), nv))
+#define _VCSIMD_EQ_i32(p, nv) _VCSIMD_MASK(_mm_cmpeq_epi32(_VCSIMD_LOAD(p), nv))
+// SSE2 has no 64-bit compare, both 32-bit halves have to match.
+static inline uint32_t _vec_simd_eq_i64(const void *p, __m128i nv) {
+    __m128i eq = _mm_cmpeq_epi32(_VCSIMD_LOAD(p), nv);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _VCSIMD_MASK(eq);
+}
+#define _VCSIMD_EQ_i64(p, nv) _vec_simd_eq_i64(p, nv)
+#define _VCSIMD_EQ_f32(p, nv)                                                  \
+    _VCSIMD_MASK(                                                              \
+        _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps((const float *)(p)), nv)))
+#define _VCSIMD_EQ_f64(p, nv)                                                  \
+    _VCSIMD_MASK(                                                              \
+        _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd((const double *)(p)), nv)))
+#endif
+
+// Scalar loads go through memcpy, the kernels are shared by every type of the
+// same width (like int and unsigned int) so they can't dereference directly.
+#define _VCSIMD_GET(ctype, d, i)                                               \
+    (memcpy(&_e, (const char *)(d) + (i) * sizeof(ctype), sizeof(ctype)), _e)
+
+#ifdef _VCSIMD_BYTES
+#define _VCSIMD_DEFINE(sfx, ctype)                                             \
+    static inline size_t _vec_find_##sfx(const void *d, size_t n, ctype x) {   \
+        const size_t step = _VCSIMD_BYTES / sizeof(ctype);                     \
+        const _VCSIMD_VT_##sfx nv = _VCSIMD_SPLAT_##sfx(x);                    \
+        const char *p = (const char *)d;                                       \
+        ctype _e;                                                              \
+        size_t i = 0;                                                          \
+        for (; i + step <= n; i += step) {                                     \
+            uint32_t m = _VCSIMD_EQ_##sfx(p + i * sizeof(ctype), nv);          \
+            if (m)                                                             \
+                return i + (size_t)__builtin_ctz(m) / sizeof(ctype);           \
+        }                                                                      \
+        for (; i < n; i++)                                                     \
+            if (_VCSIMD_GET(ctype, d, i) == x)                                 \
+                return i;                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline size_t _vec_find_last_##sfx(const void *d, size_t n,         \
+                                              ctype x) {                       \
+        const size_t step = _VCSIMD_BYTES / sizeof(ctype);                     \
+        const _VCSIMD_VT_##sfx nv = _VCSIMD_SPLAT_##sfx(x);                    \
+        const char *p = (const char *)d;                                       \
+        ctype _e;                                                              \
+        size_t i = n;                                                          \
+        for (; i >= step; i -= step) {                                         \
+            uint32_t m = _VCSIMD_EQ_##sfx(p + (i - step) * sizeof(ctype), nv); \
+            if (m)                                                             \
+                return i - step + (size_t)(31 - __builtin_clz(m)) /            \
+                                      sizeof(ctype);                           \
+        }                                                                      \
+        while (i-- > 0)                                                        \
+            if (_VCSIMD_GET(ctype, d, i) == x)                                 \
+                return i;                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline size_t _vec_count_##sfx(const void *d, size_t n, ctype x) {  \
+        const size_t step = _VCSIMD_BYTES / sizeof(ctype);                     \
+        const _VCSIMD_VT_##sfx nv = _VCSIMD_SPLAT_##sfx(x);                    \
+        const char *p = (const char *)d;                                       \
+        ctype _e;                                                              \
+        size_t bits = 0, count = 0, i = 0;                                     \
+        for (; i + step <= n; i += step)                                       \
+            bits += (size_t)__builtin_popcount(                                \
+                _VCSIMD_EQ_##sfx(p + i * sizeof(ctype), nv));                  \
+        for (; i < n; i++)                                                     \
+            count += _VCSIMD_GET(ctype, d, i) == x;                            \
+        return count + bits / sizeof(ctype);                                   \
+    }
+#else
+#define _VCSIMD_DEFINE(sfx, ctype)                                             \
+    static inline size_t _vec_find_##sfx(const void *d, size_t n, ctype x) {   \
+        ctype _e;                                                              \
+        for (size_t i = 0; i < n; i++)                                         \
+            if (_VCSIMD_GET(ctype, d, i) == x)                                 \
+                return i;                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline size_t _vec_find_last_##sfx(const void *d, size_t n,         \
+                                              ctype x) {                       \
+        ctype _e;                                                              \
+        for (size_t i = n; i-- > 0;)                                           \
+            if (_VCSIMD_GET(ctype, d, i) == x)                                 \
+                return i;                                                      \
+        return VEC_NPOS;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline size_t _vec_count_##sfx(const void *d, size_t n, ctype x) {  \
+        ctype _e;                                                              \
+        size_t count = 0;                                                      \
+        for (size_t i = 0; i < n; i++)                                         \
+            count += _VCSIMD_GET(ctype, d, i) == x;                            \
+        return count;                                                          \
+    }
+#endif
+
+_VCSIMD_DEFINE(i8, uint8_t)
+_VCSIMD_DEFINE(i16, uint16_t)
+_VCSIMD_DEFINE(i32, uint32_t)
+_VCSIMD_DEFINE(i64, uint64_t)
+_VCSIMD_DEFINE(f32, float)
+_VCSIMD_DEFINE(f64, double)
+
+// Picks the kernel matching `type`, the conditions are compile time constants
+// so only one call remains. Types without a kernel (like long double) give
+// (size_t)-2 and are handled by the scalar loop.
+#define _VCSIMD_DISPATCH(type, op, d, n, x)                                    \
+    (_VCISFLOAT(type)                                                          \
+         ? (sizeof(type) == sizeof(float)                                      \
+                ? _vec_##op##f32(d, n, (float)(x))                             \
+            : sizeof(type) == sizeof(double)                                   \
+                ? _vec_##op##f64(d, n, (double)(x))                            \
+                : (size_t)-2)                                                  \
+     : sizeof(type) == 1 ? _vec_##op##i8(d, n, (uint8_t)(x))                   \
+     : sizeof(type) == 2 ? _vec_##op##i16(d, n, (uint16_t)(x))                 \
+     : sizeof(type) == 4 ? _vec_##op##i32(d, n, (uint32_t)(x))                 \
+     : sizeof(type) == 8 ? _vec_##op##i64(d, n, (uint64_t)(x))                 \
+                         : (size_t)-2)
+
+// Search functions for primitive number vectors. Same API as
+// vec_define_contains with `a == b`, but runs on the SIMD kernels above.
+#define vec_define_search_primitive(type, name)                                \
+    vec_define_search_primitive2(type, name, name)
+#define vec_define_search_primitive2(type, name, fn_name)                      \
+    vec_define_contains2(type, name, _VCFN(fn_name, scalar), a == b)           \
+                                                                               \
+    static inline size_t _VCFN(fn_name, find_index)(name v, type b) {          \
+        size_t i = _VCSIMD_DISPATCH(type, find_, v.data, v.size, b);           \
+        return i == (size_t)-2 ? _VCFN(fn_name, scalar_find_index)(v, b) : i;  \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, find_last)(name v, type b) {           \
+        size_t i = _VCSIMD_DISPATCH(type, find_last_, v.data, v.size, b);      \
+        return i == (size_t)-2 ? _VCFN(fn_name, scalar_find_last)(v, b) : i;   \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, count)(name v, type b) {               \
+        size_t c = _VCSIMD_DISPATCH(type, count_, v.data, v.size, b);          \
+        return c == (size_t)-2 ? _VCFN(fn_name, scalar_count)(v, b) : c;       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, contains)(name v, type b) {              \
+        return _VCFN(fn_name, find_index)(v, b) != VEC_NPOS;                   \
+    }
+
+// Threads used by the parallel functions, POSIX threads on unix systems.
+// Define VEC_NO_THREADS before including vec.h to run them on the calling
+// thread only, programs using them otherwise need to link with -pthread.
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(VEC_NO_THREADS)
+#include <pthread.h>
+#define _VC_HAS_THREADS 1
+#endif
+
+// Vectors shorter than this are processed serially by the parallel functions.
+#ifndef VEC_PARALLEL_THRESHOLD
+#define VEC_PARALLEL_THRESHOLD 65536
+#endif
+// Upper bound on the threads a single parallel call starts.
+#ifndef VEC_MAX_THREADS
+#define VEC_MAX_THREADS 256
+#endif
+
+typedef void (*_vec_task_fn)(void *ctx, size_t begin, size_t end);
+
+typedef struct {
+    _vec_task_fn fn;
+    void *ctx;
+    size_t begin, end;
+} _vec_task;
+
+static inline void *_vec_task_run(void *arg) {
+    _vec_task *task = (_vec_task *)arg;
+    task->fn(task->ctx, task->begin, task->end);
+    return NULL;
+}
+
+// Range of the `t`th of `parts` nearly equal parts of [0, n).
+static inline void _vec_range(size_t n, size_t parts, size_t t, size_t *begin,
+                              size_t *end) {
+    size_t per = n / parts, extra = n % parts;
+    *begin = per * t + (t < extra ? t : extra);
+    *end = *begin + per + (t < extra);
+}
+
+// Number of threads to use when `requested` were asked for, 0 meaning one
+// per online CPU. Always 1 without thread support.
+static inline size_t _vec_thread_count(size_t requested) {
+#ifdef _VC_HAS_THREADS
+    if (requested == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        requested = cpus > 0 ? (size_t)cpus : 1;
+    }
+    return requested > VEC_MAX_THREADS ? VEC_MAX_THREADS : requested;
+#else
+    (void)requested;
+    return 1;
+#endif
+}
+
+// Splits [0, n) into `threads` contiguous ranges and calls `fn` on each one
+// in its own thread, the last range runs on the calling thread. Returns once
+// every range is done. Ranges whose thread can't be started run inline.
+static inline void _vec_parallel_for(size_t n, size_t threads,
+                                     _vec_task_fn fn, void *ctx) {
+    if (threads > n)
+        threads = n;
+#ifdef _VC_HAS_THREADS
+    if (threads > 1) {
+        _vec_task tasks[VEC_MAX_THREADS];
+        pthread_t ids[VEC_MAX_THREADS];
+        bool started[VEC_MAX_THREADS];
+        if (threads > VEC_MAX_THREADS)
+            threads = VEC_MAX_THREADS;
+        for (size_t t = 0; t < threads; t++) {
+            tasks[t].fn = fn;
+            tasks[t].ctx = ctx;
+            _vec_range(n, threads, t, &tasks[t].begin, &tasks[t].end);
+        }
+        for (size_t t = 0; t + 1 < threads; t++)
+            started[t] =
+                pthread_create(&ids[t], NULL, _vec_task_run, &tasks[t]) == 0;
+        _vec_task_run(&tasks[threads - 1]);
+        for (size_t t = 0; t + 1 < threads; t++) {
+            if (started[t])
+                pthread_join(ids[t], NULL);
+            else
+                _vec_task_run(&tasks[t]);
+        }
+        return;
+    }
+#endif
+    if (n > 0)
+        fn(ctx, 0, n);
+}
+
+// Vectors with fewer elements than this are cleared on the calling thread by
+// `clear_deferred`, starting a thread would take longer.
+#ifndef VEC_DEFERRED_THRESHOLD
+#define VEC_DEFERRED_THRESHOLD 1024
+#endif
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+} _vec_detached;
+
+#ifdef _VC_HAS_THREADS
+// Number of detached jobs still running, shared by every translation unit.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    size_t pending;
+} _vec_detached_state;
+
+__attribute__((weak)) _vec_detached_state _vec_detached_jobs = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0};
+
+static inline void _vec_detached_add(size_t n, bool finished) {
+    pthread_mutex_lock(&_vec_detached_jobs.lock);
+    _vec_detached_jobs.pending += n;
+    if (finished && _vec_detached_jobs.pending == 0)
+        pthread_cond_broadcast(&_vec_detached_jobs.done);
+    pthread_mutex_unlock(&_vec_detached_jobs.lock);
+}
+
+static inline void *_vec_detached_run(void *arg) {
+    _vec_detached job = *(_vec_detached *)arg;
+    VEC_FREE(arg);
+    job.fn(job.arg);
+    _vec_detached_add((size_t)-1, true);
+    return NULL;
+}
+#endif
+
+// Calls `fn(arg)` on a new detached thread. Returns false when there's no
+// thread support or the thread can't be started, the caller has to call `fn`
+// itself then.
+static inline bool _vec_run_detached(void (*fn)(void *), void *arg) {
+#ifdef _VC_HAS_THREADS
+    _vec_detached *job = (_vec_detached *)VEC_MALLOC(sizeof(_vec_detached));
+    pthread_attr_t attr;
+    pthread_t id;
+    if (!job)
+        return false;
+    if (pthread_attr_init(&attr) != 0) {
+        VEC_FREE(job);
+        return false;
+    }
+    job->fn = fn;
+    job->arg = arg;
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    _vec_detached_add(1, false);
+    bool started = pthread_create(&id, &attr, _vec_detached_run, job) == 0;
+    pthread_attr_destroy(&attr);
+    if (!started) {
+        _vec_detached_add((size_t)-1, true);
+        VEC_FREE(job);
+    }
+    return started;
+#else
+    (void)fn;
+    (void)arg;
+    return false;
+#endif
+}
+
+// Waits until every vector given to a `clear_deferred` function is freed, for
+// example before the program exits.
+static inline void vec_deferred_wait(void) {
+#ifdef _VC_HAS_THREADS
+    pthread_mutex_lock(&_vec_detached_jobs.lock);
+    while (_vec_detached_jobs.pending > 0)
+        pthread_cond_wait(&_vec_detached_jobs.done, &_vec_detached_jobs.lock);
+    pthread_mutex_unlock(&_vec_detached_jobs.lock);
+#endif
+}
+
+// Generates the comparison functions used by the sorting engine. `sort_less`
+// and `sort_less_rev` only differ in the order they pass the operands, so the
+// reversed sort doesn't need a second comparison expression.
+#define _vec_define_sort_cmp(type, fn_name, comp_st)                           \
+    static inline int _VCFN(fn_name, sort_cmp)(const type *a_ptr,              \
+                                               const type *b_ptr) {            \
+        const type a = *a_ptr;                                                 \
+        const type b = *b_ptr;                                                 \
+        return (comp_st);                                                      \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, sort_less)(const type *x,                \
+                                                 const type *y) {              \
+        return _VCFN(fn_name, sort_cmp)(x, y) < 0;                             \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, sort_less_rev)(const type *x,            \
+                                                     const type *y) {          \
+        return _VCFN(fn_name, sort_cmp)(y, x) < 0;                             \
+    }
+
+// Ranges up to this size are finished with insertion sort.
+#define _VCSORT_SMALL 16
+
+// Generates an introsort named `fn_name_op` ordering by the `less` function:
+// quicksort with a median of three pivot, heapsort once the recursion gets
+// too deep and insertion sort for small ranges. Everything is specialized for
+// `type`, so the comparison gets inlined and elements are moved directly.
+#define _vec_define_sort_engine(type, fn_name, op, less)                       \
+    static inline void _VCFN(fn_name, op##_insertion)(type * d, size_t n) {    \
+        for (size_t i = 1; i < n; i++) {                                       \
+            type x = d[i];                                                     \
+            size_t j = i;                                                      \
+            while (j > 0 && _VCFN(fn_name, less)(&x, &d[j - 1])) {             \
+                d[j] = d[j - 1];                                               \
+                j--;                                                           \
+            }                                                                  \
+            d[j] = x;                                                          \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, op##_sift)(type * d, size_t i,           \
+                                                 size_t n) {                   \
+        type x = d[i];                                                         \
+        for (;;) {                                                             \
+            size_t c = 2 * i + 1;                                              \
+            if (c >= n)                                                        \
+                break;                                                         \
+            if (c + 1 < n && _VCFN(fn_name, less)(&d[c], &d[c + 1]))           \
+                c++;                                                           \
+            if (!_VCFN(fn_name, less)(&x, &d[c]))                              \
+                break;                                                         \
+            d[i] = d[c];                                                       \
+            i = c;                                                             \
+        }                                                                      \
+        d[i] = x;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, op##_heap)(type * d, size_t n) {         \
+        for (size_t i = n / 2; i-- > 0;)                                       \
+            _VCFN(fn_name, op##_sift)(d, i, n);                                \
+        for (size_t i = n; i-- > 1;) {                                         \
+            type tmp = d[0];                                                   \
+            d[0] = d[i];                                                       \
+            d[i] = tmp;                                                        \
+            _VCFN(fn_name, op##_sift)(d, 0, i);                                \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, op##_intro)(type * d, size_t n,          \
+                                                  size_t depth) {              \
+        type tmp;                                                              \
+        while (n > _VCSORT_SMALL) {                                            \
+            if (depth-- == 0) {                                                \
+                _VCFN(fn_name, op##_heap)(d, n);                               \
+                return;                                                        \
+            }                                                                  \
+            size_t m = n / 2;                                                  \
+            if (_VCFN(fn_name, less)(&d[m], &d[1])) {                          \
+                tmp = d[m], d[m] = d[1], d[1] = tmp;                           \
+            }                                                                  \
+            if (_VCFN(fn_name, less)(&d[n - 1], &d[m])) {                      \
+                tmp = d[m], d[m] = d[n - 1], d[n - 1] = tmp;                   \
+                if (_VCFN(fn_name, less)(&d[m], &d[1])) {                      \
+                    tmp = d[m], d[m] = d[1], d[1] = tmp;                       \
+                }                                                              \
+            }                                                                  \
+            tmp = d[0], d[0] = d[m], d[m] = tmp;                               \
+            /* d[1] <= d[0] <= d[n - 1], so both scans stop in bounds */       \
+            size_t i = 0, j = n;                                               \
+            for (;;) {                                                         \
+                do                                                             \
+                    i++;                                                       \
+                while (_VCFN(fn_name, less)(&d[i], &d[0]));                    \
+                do                                                             \
+                    j--;                                                       \
+                while (_VCFN(fn_name, less)(&d[0], &d[j]));                    \
+                if (i >= j)                                                    \
+                    break;                                                     \
+                tmp = d[i], d[i] = d[j], d[j] = tmp;                           \
+            }                                                                  \
+            tmp = d[0], d[0] = d[j], d[j] = tmp;                               \
+            if (j < n - j - 1) {                                               \
+                _VCFN(fn_name, op##_intro)(d, j, depth);                       \
+                d += j + 1;                                                    \
+                n -= j + 1;                                                    \
+            } else {                                                           \
+                _VCFN(fn_name, op##_intro)(d + j + 1, n - j - 1, depth);       \
+                n = j;                                                         \
+            }                                                                  \
+        }                                                                      \
+        _VCFN(fn_name, op##_insertion)(d, n);                                  \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, op)(type * d, size_t n) {                \
+        size_t depth = 0;                                                      \
+        for (size_t k = n; k > 1; k >>= 1)                                     \
+            depth += 2;                                                        \
+        _VCFN(fn_name, op##_intro)(d, n, depth);                               \
+    }
+
+// Stable merge sort over the same comparison functions, used by the stable
+// sorts. `op##_merge` merges two sorted ranges, taking from the first one on
+// ties, and is also what joins the chunks of the parallel sorts.
+#define _vec_define_stable_engine(type, fn_name, op, less)                     \
+    static inline void _VCFN(fn_name, op##_merge)(                             \
+        const type *a, size_t na, const type *b, size_t nb, type *out) {       \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < na && j < nb)                                               \
+            out[k++] = _VCFN(fn_name, less)(&b[j], &a[i]) ? b[j++] : a[i++];   \
+        memcpy(out + k, a + i, sizeof(type) * (na - i));                       \
+        memcpy(out + k + na - i, b + j, sizeof(type) * (nb - j));              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, op)(type * d, size_t n) {                \
+        for (size_t s = 0; s < n; s += _VCSORT_SMALL) {                        \
+            size_t e = s + _VCSORT_SMALL < n ? s + _VCSORT_SMALL : n;          \
+            for (size_t i = s + 1; i < e; i++) {                               \
+                type x = d[i];                                                 \
+                size_t j = i;                                                  \
+                while (j > s && _VCFN(fn_name, less)(&x, &d[j - 1])) {         \
+                    d[j] = d[j - 1];                                           \
+                    j--;                                                       \
+                }                                                              \
+                d[j] = x;                                                      \
+            }                                                                  \
+        }                                                                      \
+        if (n <= _VCSORT_SMALL)                                                \
+            return;                                                            \
+        type *tmp = (type *)VEC_MALLOC(sizeof(type) * n);                      \
+        if (!tmp) {                                                            \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        type *src = d, *dst = tmp;                                             \
+        for (size_t w = _VCSORT_SMALL; w < n; w *= 2) {                        \
+            for (size_t s = 0; s < n; s += 2 * w) {                            \
+                size_t m = s + w < n ? s + w : n;                              \
+                size_t e = s + 2 * w < n ? s + 2 * w : n;                      \
+                _VCFN(fn_name, op##_merge)(src + s, m - s, src + m, e - m,     \
+                                           dst + s);                           \
+            }                                                                  \
+            type *swap = src;                                                  \
+            src = dst;                                                         \
+            dst = swap;                                                        \
+        }                                                                      \
+        if (src != d)                                                          \
+            memcpy(d, src, sizeof(type) * n);                                  \
+        VEC_FREE(tmp);                                                         \
+    }
+
+// Parallel sorts: the vector is cut into one chunk per thread, the chunks are
+// sorted at the same time and then merged pairwise, every round of merges
+// running in parallel too. The result doesn't depend on the thread count for
+// the stable variants. `threads` 0 uses one thread per online CPU.
+#define _vec_define_parallel_sort(type, name, fn_name)                         \
+    typedef struct {                                                           \
+        type *src, *dst;                                                       \
+        size_t n, chunk, width;                                                \
+        void (*sort_range)(type *, size_t);                                    \
+        void (*merge)(const type *, size_t, const type *, size_t, type *);     \
+    } _VCFN(fn_name, psort_ctx);                                               \
+                                                                               \
+    static inline void _VCFN(fn_name, psort_chunks)(void *arg, size_t begin,   \
+                                                    size_t end) {              \
+        _VCFN(fn_name, psort_ctx) *ctx = (_VCFN(fn_name, psort_ctx) *)arg;     \
+        for (size_t c = begin; c < end; c++) {                                 \
+            size_t s = c * ctx->chunk;                                         \
+            size_t e = s + ctx->chunk < ctx->n ? s + ctx->chunk : ctx->n;      \
+            ctx->sort_range(ctx->src + s, e - s);                              \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, psort_merges)(void *arg, size_t begin,   \
+                                                    size_t end) {              \
+        _VCFN(fn_name, psort_ctx) *ctx = (_VCFN(fn_name, psort_ctx) *)arg;     \
+        for (size_t p = begin; p < end; p++) {                                 \
+            size_t s = p * 2 * ctx->width;                                     \
+            size_t m = s + ctx->width < ctx->n ? s + ctx->width : ctx->n;      \
+            size_t e = s + 2 * ctx->width < ctx->n ? s + 2 * ctx->width        \
+                                                   : ctx->n;                   \
+            ctx->merge(ctx->src + s, m - s, ctx->src + m, e - m,               \
+                       ctx->dst + s);                                          \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_sort_with)(                     \
+        name * v, size_t threads, void (*sort_range)(type *, size_t),          \
+        void (*merge)(const type *, size_t, const type *, size_t, type *)) {   \
+        name##_detach(v);                                                      \
+        threads = _vec_thread_count(threads);                                  \
+        if (threads < 2 || v->size < VEC_PARALLEL_THRESHOLD) {                 \
+            sort_range(v->data, v->size);                                      \
+            return;                                                            \
+        }                                                                      \
+        _VCFN(fn_name, psort_ctx) ctx;                                         \
+        ctx.src = v->data;                                                     \
+        ctx.dst = (type *)VEC_MALLOC(sizeof(type) * v->size);                  \
+        if (!ctx.dst) {                                                        \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        type *tmp = ctx.dst;                                                   \
+        ctx.n = v->size;                                                       \
+        ctx.chunk = (v->size + threads - 1) / threads;                         \
+        ctx.sort_range = sort_range;                                           \
+        ctx.merge = merge;                                                     \
+        size_t chunks = (v->size + ctx.chunk - 1) / ctx.chunk;                 \
+        _vec_parallel_for(chunks, threads, _VCFN(fn_name, psort_chunks),       \
+                          &ctx);                                               \
+        for (ctx.width = ctx.chunk; ctx.width < ctx.n; ctx.width *= 2) {       \
+            size_t pairs = (ctx.n + 2 * ctx.width - 1) / (2 * ctx.width);      \
+            _vec_parallel_for(pairs, threads, _VCFN(fn_name, psort_merges),    \
+                              &ctx);                                           \
+            type *swap = ctx.src;                                              \
+            ctx.src = ctx.dst;                                                 \
+            ctx.dst = swap;                                                    \
+        }                                                                      \
+        if (ctx.src != v->data)                                                \
+            memcpy(v->data, ctx.src, sizeof(type) * v->size);                  \
+        VEC_FREE(tmp);                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_sort)(name * v,                 \
+                                                     size_t threads) {         \
+        _VCFN(fn_name, parallel_sort_with)(                                    \
+            v, threads, _VCFN(fn_name, sort_range),                            \
+            _VCFN(fn_name, sort_stable_range_merge));                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_sort_reversed)(                 \
+        name * v, size_t threads) {                                            \
+        _VCFN(fn_name, parallel_sort_with)(                                    \
+            v, threads, _VCFN(fn_name, sort_range_rev),                        \
+            _VCFN(fn_name, sort_stable_range_rev_merge));                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_sort_stable)(name * v,          \
+                                                            size_t threads) {  \
+        _VCFN(fn_name, parallel_sort_with)(                                    \
+            v, threads, _VCFN(fn_name, sort_stable_range),                     \
+            _VCFN(fn_name, sort_stable_range_merge));                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_sort_stable_reversed)(          \
+        name * v, size_t threads) {                                            \
+        _VCFN(fn_name, parallel_sort_with)(                                    \
+            v, threads, _VCFN(fn_name, sort_stable_range_rev),                 \
+            _VCFN(fn_name, sort_stable_range_rev_merge));                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_stable)(name * v) {                 \
+        name##_detach(v);                                                      \
+        _VCFN(fn_name, sort_stable_range)(v->data, v->size);                   \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_stable_reversed)(name * v) {        \
+        name##_detach(v);                                                      \
+        _VCFN(fn_name, sort_stable_range_rev)(v->data, v->size);               \
+    }
+
+#define vec_define_sort(type, name, comp_st)                                   \
+    vec_define_sort2(type, name, name, comp_st)
+#define vec_define_sort2(type, name, fn_name, comp_st)                         \
+    _vec_define_sort_cmp(type, fn_name, comp_st)                               \
+    _vec_define_sort_engine(type, fn_name, sort_range, sort_less)              \
+    _vec_define_sort_engine(type, fn_name, sort_range_rev, sort_less_rev)      \
+    _vec_define_stable_engine(type, fn_name, sort_stable_range, sort_less)     \
+    _vec_define_stable_engine(type, fn_name, sort_stable_range_rev,            \
+                              sort_less_rev)                                   \
+    _vec_define_parallel_sort(type, name, fn_name)                             \
+                                                                               \
+    static inline void _VCFN(fn_name, sort)(name * v) {                        \
+        name##_detach(v);                                                      \
+        _VCFN(fn_name, sort_range)(v->data, v->size);                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_reversed)(name * v) {               \
+        name##_detach(v);                                                      \
+        _VCFN(fn_name, sort_range_rev)(v->data, v->size);                      \
+    }
+
+// Vectors shorter than this are sorted with the comparison sort.
+#define _VCRADIX_MIN 256
+
+// Sorting for primitive integer and floating point types. Big vectors are
+// sorted with an LSD radix sort on an order preserving unsigned key, the
+// others (and types the key can't represent, like long double) fall back to
+// the introsort used by vec_define_sort.
+#define vec_define_sort_radix(type, name)                                      \
+    vec_define_sort_radix2(type, name, name)
+#define vec_define_sort_radix2(type, name, fn_name)                            \
+    _vec_define_sort_cmp(type, fn_name, (a > b) - (a < b))                     \
+    _vec_define_sort_engine(type, fn_name, sort_range, sort_less)              \
+    _vec_define_sort_engine(type, fn_name, sort_range_rev, sort_less_rev)      \
+    _vec_define_stable_engine(type, fn_name, sort_stable_range, sort_less)     \
+    _vec_define_stable_engine(type, fn_name, sort_stable_range_rev,            \
+                              sort_less_rev)                                   \
+    _vec_define_parallel_sort(type, name, fn_name)                             \
+                                                                               \
+    static inline bool _VCFN(fn_name, radix_supported)(void) {                 \
+        if (_VCISFLOAT(type))                                                  \
+            return sizeof(type) == sizeof(uint32_t) ||                         \
+                   sizeof(type) == sizeof(uint64_t);                           \
+        return sizeof(type) <= sizeof(uint64_t);                               \
+    }                                                                          \
+                                                                               \
+    static inline uint64_t _VCFN(fn_name, radix_key)(type x) {                 \
+        if (_VCISFLOAT(type)) {                                                \
+            union {                                                            \
+                type t;                                                        \
+                uint32_t u32;                                                  \
+                uint64_t u64;                                                  \
+            } k;                                                               \
+            k.t = x;                                                           \
+            if (sizeof(type) == sizeof(uint32_t))                              \
+                return k.u32 >> 31 ? (uint32_t)~k.u32                          \
+                                   : k.u32 ^ ((uint32_t)1 << 31);              \
+            return k.u64 >> 63 ? ~k.u64 : k.u64 ^ ((uint64_t)1 << 63);         \
+        }                                                                      \
+        if (!_VCISSIGNED(type))                                                \
+            return (uint64_t)x;                                                \
+        uint64_t bits = sizeof(type) * 8;                                      \
+        uint64_t key = (uint64_t)(int64_t)x ^ ((uint64_t)1 << (bits - 1));     \
+        return bits == 64 ? key : key & (((uint64_t)1 << bits) - 1);           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, radix_sort)(type * d, size_t n) {        \
+        size_t counts[sizeof(type)][256];                                      \
+        memset(counts, 0, sizeof(counts));                                     \
+        for (size_t i = 0; i < n; i++) {                                       \
+            uint64_t key = _VCFN(fn_name, radix_key)(d[i]);                    \
+            for (size_t p = 0; p < sizeof(type); p++)                          \
+                counts[p][(key >> (p * 8)) & 0xff]++;                          \
+        }                                                                      \
+        type *tmp = (type *)VEC_MALLOC(sizeof(type) * n);                      \
+        if (!tmp) {                                                            \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        type *src = d, *dst = tmp;                                             \
+        for (size_t p = 0; p < sizeof(type); p++) {                            \
+            size_t *count = counts[p];                                         \
+            size_t offset = 0;                                                 \
+            bool trivial = false;                                              \
+            for (size_t b = 0; b < 256; b++) {                                 \
+                size_t c = count[b];                                           \
+                if (c == n)                                                    \
+                    trivial = true;                                            \
+                count[b] = offset;                                             \
+                offset += c;                                                   \
+            }                                                                  \
+            if (trivial)                                                       \
+                continue;                                                      \
+            for (size_t i = 0; i < n; i++) {                                   \
+                uint64_t key = _VCFN(fn_name, radix_key)(src[i]);              \
+                dst[count[(key >> (p * 8)) & 0xff]++] = src[i];                \
+            }                                                                  \
+            type *swap = src;                                                  \
+            src = dst;                                                         \
+            dst = swap;                                                        \
+        }                                                                      \
+        if (src != d)                                                          \
+            memcpy(d, src, sizeof(type) * n);                                  \
+        VEC_FREE(tmp);                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort)(name * v) {                        \
+        name##_detach(v);                                                      \
+        if (v->size < _VCRADIX_MIN || !_VCFN(fn_name, radix_supported)())      \
+            _VCFN(fn_name, sort_range)(v->data, v->size);                      \
+        else                                                                   \
+            _VCFN(fn_name, radix_sort)(v->data, v->size);                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, sort_reversed)(name * v) {               \
+        name##_detach(v);                                                      \
+        if (v->size < _VCRADIX_MIN || !_VCFN(fn_name, radix_supported)()) {    \
+            _VCFN(fn_name, sort_range_rev)(v->data, v->size);                  \
+            return;                                                            \
+        }                                                                      \
+        _VCFN(fn_name, radix_sort)(v->data, v->size);                          \
+        for (size_t i = 0; i < v->size / 2; i++) {                             \
+            type tmp = v->data[i];                                             \
+            v->data[i] = v->data[v->size - 1 - i];                             \
+            v->data[v->size - 1 - i] = tmp;                                    \
+        }                                                                      \
+    }
+
+// Functions for vectors kept sorted by `comp_st`, which works like
+// vec_define_sort's. Searches are binary and the merge and set functions are
+// linear. The set functions write to `out`, which can't be one of the inputs,
+// and replace its previous contents.
+#define vec_define_sorted(type, name, comp_st)                                 \
+    vec_define_sorted2(type, name, name, comp_st)
+#define vec_define_sorted2(type, name, fn_name, comp_st)                       \
+    static inline int _VCFN(fn_name, sorted_cmp)(const type *a_ptr,            \
+                                                 const type *b_ptr) {          \
+        const type a = *a_ptr;                                                 \
+        const type b = *b_ptr;                                                 \
+        return (comp_st);                                                      \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, lower_bound)(name v, type x) {         \
+        if (v.size == 0)                                                       \
+            return 0;                                                          \
+        const type *base = v.data;                                             \
+        size_t n = v.size;                                                     \
+        while (n > 1) {                                                        \
+            size_t half = n / 2;                                               \
+            base += _VCFN(fn_name, sorted_cmp)(base + half, &x) < 0 ? half : 0; \
+            n -= half;                                                         \
+        }                                                                      \
+        return (size_t)(base - v.data) +                                       \
+               (_VCFN(fn_name, sorted_cmp)(base, &x) < 0);                     \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, upper_bound)(name v, type x) {         \
+        if (v.size == 0)                                                       \
+            return 0;                                                          \
+        const type *base = v.data;                                             \
+        size_t n = v.size;                                                     \
+        while (n > 1) {                                                        \
+            size_t half = n / 2;                                               \
+            base +=                                                            \
+                _VCFN(fn_name, sorted_cmp)(base + half, &x) <= 0 ? half : 0;   \
+            n -= half;                                                         \
+        }                                                                      \
+        return (size_t)(base - v.data) +                                       \
+               (_VCFN(fn_name, sorted_cmp)(base, &x) <= 0);                    \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, binary_contains)(name v, type x) {       \
+        size_t i = _VCFN(fn_name, lower_bound)(v, x);                          \
+        return i < v.size && _VCFN(fn_name, sorted_cmp)(&v.data[i], &x) == 0;  \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, insert_sorted)(name * v, type x) {     \
+        size_t i = _VCFN(fn_name, upper_bound)(*v, x);                         \
+        _VCFN(fn_name, insert_n)(v, i, &x, 1);                                 \
+        return i;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, unique)(name * v) {                    \
+        name##_detach(v);                                                      \
+        if (v->size == 0)                                                      \
+            return 0;                                                          \
+        size_t j = 1;                                                          \
+        for (size_t i = 1; i < v->size; i++) {                                 \
+            if (_VCFN(fn_name, sorted_cmp)(&v->data[j - 1], &v->data[i]) == 0) \
+                continue;                                                      \
+            if (i != j)                                                        \
+                v->data[j] = v->data[i];                                       \
+            j++;                                                               \
+        }                                                                      \
+        size_t removed = v->size - j;                                          \
+        v->size = j;                                                           \
+        return removed;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, merge)(name a, name b, name * out) {     \
+        out->size = 0;                                                         \
+        _VCFN(fn_name, grow)(out, a.size + b.size);                            \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a.size && j < b.size)                                       \
+            out->data[k++] =                                                   \
+                _VCFN(fn_name, sorted_cmp)(&b.data[j], &a.data[i]) < 0         \
+                    ? b.data[j++]                                              \
+                    : a.data[i++];                                             \
+        memcpy(out->data + k, a.data + i, sizeof(type) * (a.size - i));        \
+        k += a.size - i;                                                       \
+        memcpy(out->data + k, b.data + j, sizeof(type) * (b.size - j));        \
+        out->size = k + b.size - j;                                            \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set_union)(name a, name b, name * out) { \
+        out->size = 0;                                                         \
+        _VCFN(fn_name, grow)(out, a.size + b.size);                            \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a.size && j < b.size) {                                     \
+            int c = _VCFN(fn_name, sorted_cmp)(&a.data[i], &b.data[j]);        \
+            out->data[k++] = c <= 0 ? a.data[i] : b.data[j];                   \
+            i += c <= 0;                                                       \
+            j += c >= 0;                                                       \
+        }                                                                      \
+        memcpy(out->data + k, a.data + i, sizeof(type) * (a.size - i));        \
+        k += a.size - i;                                                       \
+        memcpy(out->data + k, b.data + j, sizeof(type) * (b.size - j));        \
+        out->size = k + b.size - j;                                            \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set_intersection)(name a, name b,        \
+                                                        name * out) {          \
+        out->size = 0;                                                         \
+        _VCFN(fn_name, grow)(out, a.size < b.size ? a.size : b.size);          \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a.size && j < b.size) {                                     \
+            int c = _VCFN(fn_name, sorted_cmp)(&a.data[i], &b.data[j]);        \
+            if (c == 0)                                                        \
+                out->data[k++] = a.data[i];                                    \
+            i += c <= 0;                                                       \
+            j += c >= 0;                                                       \
+        }                                                                      \
+        out->size = k;                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set_difference)(name a, name b,          \
+                                                      name * out) {            \
+        out->size = 0;                                                         \
+        _VCFN(fn_name, grow)(out, a.size);                                     \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a.size && j < b.size) {                                     \
+            int c = _VCFN(fn_name, sorted_cmp)(&a.data[i], &b.data[j]);        \
+            if (c < 0)                                                         \
+                out->data[k++] = a.data[i];                                    \
+            i += c <= 0;                                                       \
+            j += c >= 0;                                                       \
+        }                                                                      \
+        memcpy(out->data + k, a.data + i, sizeof(type) * (a.size - i));        \
+        out->size = k + a.size - i;                                            \
+    }
+
+// Open addressing (Robin Hood) index from the values of a vector to their
+// positions, built by vec_define_hashindex. Slots store the position and the
+// full hash, so most mismatches are rejected without reading the vector.
+typedef struct {
+    size_t pos;
+    uint64_t hash;
+} _vec_hash_slot;
+
+typedef struct {
+    size_t capacity, count;
+    _vec_hash_slot *slots;
+} vec_hashindex;
+
+// Spreads the bits of a user hash, identity hashes of integers are common.
+static inline uint64_t _vec_hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline size_t _vec_hashindex_dist(const vec_hashindex *idx, size_t i) {
+    return (i - (size_t)idx->slots[i].hash) & (idx->capacity - 1);
+}
+
+static inline void _vec_hashindex_place(vec_hashindex *idx, uint64_t hash,
+                                        size_t pos) {
+    size_t mask = idx->capacity - 1;
+    _vec_hash_slot e = {pos, hash};
+    size_t i = (size_t)hash & mask, d = 0;
+    while (idx->slots[i].pos != VEC_NPOS) {
+        size_t sd = _vec_hashindex_dist(idx, i);
+        if (sd < d) {
+            _vec_hash_slot tmp = idx->slots[i];
+            idx->slots[i] = e;
+            e = tmp;
+            d = sd;
+        }
+        i = (i + 1) & mask;
+        d++;
+    }
+    idx->slots[i] = e;
+}
+
+static inline void _vec_hashindex_resize(vec_hashindex *idx, size_t capacity) {
+    vec_hashindex old = *idx;
+    idx->slots =
+        (_vec_hash_slot *)VEC_MALLOC(sizeof(_vec_hash_slot) * capacity);
+    if (!idx->slots) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    idx->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++)
+        idx->slots[i].pos = VEC_NPOS;
+    for (size_t i = 0; i < old.capacity; i++)
+        if (old.slots[i].pos != VEC_NPOS)
+            _vec_hashindex_place(idx, old.slots[i].hash, old.slots[i].pos);
+    VEC_FREE(old.slots);
+}
+
+// Initializes an empty index that can hold `n` positions before growing.
+static inline void vec_hashindex_init(vec_hashindex *idx, size_t n) {
+    size_t capacity = 16;
+    while (capacity - capacity / 8 < n)
+        capacity *= 2;
+    idx->capacity = 0;
+    idx->count = 0;
+    idx->slots = NULL;
+    _vec_hashindex_resize(idx, capacity);
+}
+
+static inline void vec_hashindex_free(vec_hashindex *idx) {
+    VEC_FREE(idx->slots);
+    idx->slots = NULL;
+    idx->capacity = 0;
+    idx->count = 0;
+}
+
+// Adds a position with the hash of its value, keeps the load under 7/8.
+static inline void _vec_hashindex_insert(vec_hashindex *idx, uint64_t hash,
+                                         size_t pos) {
+    if (idx->count + 1 > idx->capacity - idx->capacity / 8)
+        _vec_hashindex_resize(idx, idx->capacity * 2);
+    _vec_hashindex_place(idx, hash, pos);
+    idx->count++;
+}
+
+// Removes a position, shifting the rest of its cluster back one slot.
+static inline void _vec_hashindex_remove(vec_hashindex *idx, uint64_t hash,
+                                         size_t pos) {
+    size_t mask = idx->capacity - 1;
+    size_t i = (size_t)hash & mask, d = 0;
+    while (idx->slots[i].pos != pos) {
+        if (idx->slots[i].pos == VEC_NPOS || _vec_hashindex_dist(idx, i) < d)
+            return;
+        i = (i + 1) & mask;
+        d++;
+    }
+    size_t j = (i + 1) & mask;
+    while (idx->slots[j].pos != VEC_NPOS && _vec_hashindex_dist(idx, j) > 0) {
+        idx->slots[i] = idx->slots[j];
+        i = j;
+        j = (j + 1) & mask;
+    }
+    idx->slots[i].pos = VEC_NPOS;
+    idx->count--;
+}
+
+// Hash index for a vector: `hash_st` hashes an element `a` and `eq_st` works
+// like vec_define_contains's. The index only follows the vector through the
+// `_indexed` functions, rebuild it after changing the vector any other way.
+// Equal elements all get an entry, `index_of` returns the smallest position.
+#define vec_define_hashindex(type, name, hash_st, eq_st)                       \
+    vec_define_hashindex2(type, name, name, hash_st, eq_st)
+#define vec_define_hashindex2(type, name, fn_name, hash_st, eq_st)             \
+    static inline uint64_t _VCFN(fn_name, hash)(type a) {                      \
+        return _vec_hash_mix((uint64_t)(hash_st));                             \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, index_lookup)(                         \
+        const vec_hashindex *idx, const type *data, uint64_t hash, type b) {   \
+        size_t mask = idx->capacity - 1, found = VEC_NPOS;                     \
+        size_t i = (size_t)hash & mask, d = 0;                                 \
+        while (idx->slots[i].pos != VEC_NPOS &&                                \
+               _vec_hashindex_dist(idx, i) >= d) {                             \
+            if (idx->slots[i].hash == hash && idx->slots[i].pos < found) {     \
+                type a = data[idx->slots[i].pos];                              \
+                if (eq_st)                                                     \
+                    found = idx->slots[i].pos;                                 \
+            }                                                                  \
+            i = (i + 1) & mask;                                                \
+            d++;                                                               \
+        }                                                                      \
+        return found;                                                          \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, index_build)(vec_hashindex * idx,        \
+                                                   name v) {                   \
+        vec_hashindex_init(idx, v.size);                                       \
+        for (size_t i = 0; i < v.size; i++)                                    \
+            _vec_hashindex_insert(idx, _VCFN(fn_name, hash)(v.data[i]), i);    \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, index_of)(const vec_hashindex *idx,    \
+                                                  name v, type x) {            \
+        return _VCFN(fn_name, index_lookup)(idx, v.data,                       \
+                                            _VCFN(fn_name, hash)(x), x);       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, contains_fast)(const vec_hashindex *idx, \
+                                                     name v, type x) {         \
+        return _VCFN(fn_name, index_of)(idx, v, x) != VEC_NPOS;                \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, push_indexed)(name * v,                  \
+                                                    vec_hashindex * idx,       \
+                                                    type x) {                  \
+        _vec_hashindex_insert(idx, _VCFN(fn_name, hash)(x), v->size);          \
+        _VCFN(fn_name, push)(v, x);                                            \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, pop_indexed)(name * v,                   \
+                                                   vec_hashindex * idx) {      \
+        if (v->size == 0) {                                                    \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        type x = v->data[v->size - 1];                                         \
+        _vec_hashindex_remove(idx, _VCFN(fn_name, hash)(x), v->size - 1);      \
+        v->size--;                                                             \
+        return x;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, set_indexed)(                            \
+        name * v, vec_hashindex * idx, size_t i, type x) {                     \
+        name##_detach(v);                                                      \
+        if (i >= v->size) {                                                    \
+            perror("vector index out of bounds");                              \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+                                                                               \
+        _vec_hashindex_remove(idx, _VCFN(fn_name, hash)(v->data[i]), i);       \
+        v->data[i] = x;                                                        \
+        _vec_hashindex_insert(idx, _VCFN(fn_name, hash)(x), i);                \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, dedupe)(name * v) {                    \
+        name##_detach(v);                                                      \
+        vec_hashindex idx;                                                     \
+        vec_hashindex_init(&idx, v->size);                                     \
+        size_t j = 0;                                                          \
+        for (size_t i = 0; i < v->size; i++) {                                 \
+            type x = v->data[i];                                               \
+            uint64_t hash = _VCFN(fn_name, hash)(x);                           \
+            if (_VCFN(fn_name, index_lookup)(&idx, v->data, hash, x) !=        \
+                VEC_NPOS)                                                      \
+                continue;                                                      \
+            v->data[j] = x;                                                    \
+            _vec_hashindex_insert(&idx, hash, j++);                            \
+        }                                                                      \
+        vec_hashindex_free(&idx);                                              \
+        size_t removed = v->size - j;                                          \
+        v->size = j;                                                           \
+        return removed;                                                        \
+    }
+
+// Removes every element `pred_st` is true for, keeping the order of the
+// others. The element is `a` and `ctx` is the pointer given to `remove_if`.
+// The removed elements aren't freed. Returns the number of removed elements.
+#define vec_define_remove_if(type, name, pred_st)                              \
+    vec_define_remove_if2(type, name, name, pred_st)
+#define vec_define_remove_if2(type, name, fn_name, pred_st)                    \
+    static inline size_t _VCFN(fn_name, remove_if)(name * v, void *ctx) {      \
+        name##_detach(v);                                                      \
+        (void)ctx;                                                             \
+        size_t j = 0;                                                          \
+        for (size_t i = 0; i < v->size; i++) {                                 \
+            type a = v->data[i];                                               \
+            if (pred_st)                                                       \
+                continue;                                                      \
+            if (i != j)                                                        \
+                v->data[j] = a;                                                \
+            j++;                                                               \
+        }                                                                      \
+        size_t removed = v->size - j;                                          \
+        v->size = j;                                                           \
+        return removed;                                                        \
+    }
+
+// Marks the pointers of the ops loops as not aliasing, so they vectorize.
+#ifdef __cplusplus
+#define _VCRESTRICT __restrict
+#else
+#define _VCRESTRICT restrict
+#endif
+
+// Element wise operations, each one defined as `name_op` with the name given
+// as `op`. The expressions see the element as `a` and the pointer given to
+// the function as `ctx`, like vec_define_remove_if. Every operation also has
+// a `name_parallel_op` variant that splits the vector between `threads`
+// threads (0 for one per CPU) when it has at least VEC_PARALLEL_THRESHOLD
+// elements, the expressions must be thread safe then.
+
+// `name_op(&v, ctx)` replaces every element with `map_st`.
+#define vec_define_ops_map(type, name, op, map_st)                             \
+    vec_define_ops_map2(type, name, name, op, map_st)
+#define vec_define_ops_map2(type, name, fn_name, op, map_st)                   \
+    static inline void _VCFN(fn_name, op##_range)(                             \
+        type *_VCRESTRICT d, size_t n, void *ctx) {                            \
+        (void)ctx;                                                             \
+        for (size_t i = 0; i < n; i++) {                                       \
+            type a = d[i];                                                     \
+            d[i] = (map_st);                                                   \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    typedef struct {                                                           \
+        type *data;                                                            \
+        void *ctx;                                                             \
+    } _VCFN(fn_name, op##_ctx);                                                \
+                                                                               \
+    static inline void _VCFN(fn_name, op##_task)(void *arg, size_t begin,      \
+                                                 size_t end) {                 \
+        _VCFN(fn_name, op##_ctx) *c = (_VCFN(fn_name, op##_ctx) *)arg;         \
+        _VCFN(fn_name, op##_range)(c->data + begin, end - begin, c->ctx);      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, op)(name * v, void *ctx) {               \
+        name##_detach(v);                                                      \
+        _VCFN(fn_name, op##_range)(v->data, v->size, ctx);                     \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_##op)(                          \
+        name * v, void *ctx, size_t threads) {                                 \
+        name##_detach(v);                                                      \
+        threads = _vec_thread_count(threads);                                  \
+        if (threads < 2 || v->size < VEC_PARALLEL_THRESHOLD) {                 \
+            _VCFN(fn_name, op##_range)(v->data, v->size, ctx);                 \
+            return;                                                            \
+        }                                                                      \
+        _VCFN(fn_name, op##_ctx) c = {v->data, ctx};                           \
+        _vec_parallel_for(v->size, threads, _VCFN(fn_name, op##_task), &c);    \
+    }
+
+// `name_op(v, ctx)` folds the elements into an `acc_type` starting from
+// `init`, `step_st` gives the next `acc` from `acc` and `a`. The parallel
+// variant folds each part separately and joins them with `combine_st`, which
+// gives the next `acc` from `acc` and the result of the next part `b`.
+#define vec_define_ops_reduce(type, name, op, acc_type, init, step_st,         \
+                              combine_st)                                      \
+    vec_define_ops_reduce2(type, name, name, op, acc_type, init, step_st,      \
+                           combine_st)
+#define vec_define_ops_reduce2(type, name, fn_name, op, acc_type, init,        \
+                               step_st, combine_st)                            \
+    static inline acc_type _VCFN(fn_name, op##_range)(                         \
+        const type *_VCRESTRICT d, size_t n, void *ctx) {                      \
+        (void)ctx;                                                             \
+        acc_type acc = (init);                                                 \
+        for (size_t i = 0; i < n; i++) {                                       \
+            type a = d[i];                                                     \
+            acc = (step_st);                                                   \
+        }                                                                      \
+        return acc;                                                            \
+    }                                                                          \
+                                                                               \
+    typedef struct {                                                           \
+        const type *data;                                                      \
+        size_t n, parts;                                                       \
+        acc_type *partials;                                                    \
+        void *ctx;                                                             \
+    } _VCFN(fn_name, op##_ctx);                                                \
+                                                                               \
+    static inline void _VCFN(fn_name, op##_task)(void *arg, size_t begin,      \
+                                                 size_t end) {                 \
+        _VCFN(fn_name, op##_ctx) *c = (_VCFN(fn_name, op##_ctx) *)arg;         \
+        for (size_t t = begin; t < end; t++) {                                 \
+            size_t s, e;                                                       \
+            _vec_range(c->n, c->parts, t, &s, &e);                             \
+            c->partials[t] =                                                   \
+                _VCFN(fn_name, op##_range)(c->data + s, e - s, c->ctx);        \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline acc_type _VCFN(fn_name, op)(name v, void *ctx) {             \
+        return _VCFN(fn_name, op##_range)(v.data, v.size, ctx);                \
+    }                                                                          \
+                                                                               \
+    static inline acc_type _VCFN(fn_name, parallel_##op)(                      \
+        name v, void *ctx, size_t threads) {                                   \
+        threads = _vec_thread_count(threads);                                  \
+        if (threads < 2 || v.size < VEC_PARALLEL_THRESHOLD)                    \
+            return _VCFN(fn_name, op##_range)(v.data, v.size, ctx);            \
+        _VCFN(fn_name, op##_ctx) c = {v.data, v.size, threads, NULL, ctx};     \
+        c.partials = (acc_type *)VEC_MALLOC(sizeof(acc_type) * threads);       \
+        if (!c.partials) {                                                     \
+            perror("malloc failed");                                           \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
+        _vec_parallel_for(threads, threads, _VCFN(fn_name, op##_task), &c);    \
+        acc_type acc = c.partials[0];                                          \
+        for (size_t t = 1; t < threads; t++) {                                 \
+            acc_type b = c.partials[t];                                        \
+            acc = (combine_st);                                                \
+        }                                                                      \
+        VEC_FREE(c.partials);                                                  \
+        return acc;                                                            \
+    }
 
-#define vec_define2(type, name, fn_name)                                       \
+// `name_op(v, &out, ctx)` replaces the contents of `out` with the
+// elements `pred_st` is true for, in order. `out` can't be `v` (use
+// vec_define_remove_if for that) and its capacity grows to the size of `v`.
+#define vec_define_ops_filter(type, name, op, pred_st)                         \
+    vec_define_ops_filter2(type, name, name, op, pred_st)
+#define vec_define_ops_filter2(type, name, fn_name, op, pred_st)               \
+    static inline size_t _VCFN(fn_name, op##_range)(                           \
+        const type *_VCRESTRICT d, size_t n, type *_VCRESTRICT out,            \
+        void *ctx) {                                                           \
+        (void)ctx;                                                             \
+        size_t k = 0;                                                          \
+        for (size_t i = 0; i < n; i++) {                                       \
+            type a = d[i];                                                     \
+            out[k] = a;                                                        \
+            k += (pred_st) ? 1 : 0;                                            \
+        }                                                                      \
+        return k;                                                              \
+    }                                                                          \
+                                                                               \
     typedef struct {                                                           \
-        size_t size, capacity;                                                 \
-        type *data;                                                            \
-    } name;                                                                    \
+        const type *data;                                                      \
+        type *out;                                                             \
+        size_t n, parts;                                                       \
+        size_t *offsets;                                                       \
+        void *ctx;                                                             \
+    } _VCFN(fn_name, op##_ctx);                                                \
                                                                                \
-    static inline name *_VCFN(fn_name, alloc)(void) {                          \
-        return (name *)malloc(sizeof(name));                                   \
+    static inline void _VCFN(fn_name, op##_task)(void *arg, size_t begin,      \
+                                                 size_t end) {                 \
+        _VCFN(fn_name, op##_ctx) *c = (_VCFN(fn_name, op##_ctx) *)arg;         \
+        void *ctx = c->ctx;                                                    \
+        (void)ctx;                                                             \
+        for (size_t t = begin; t < end; t++) {                                 \
+            size_t s, e;                                                       \
+            _vec_range(c->n, c->parts, t, &s, &e);                             \
+            size_t k = 0;                                                      \
+            for (size_t i = s; i < e; i++) {                                   \
+                type a = c->data[i];                                           \
+                if (!(pred_st))                                                \
+                    continue;                                                  \
+                if (c->out)                                                    \
+                    c->out[c->offsets[t] + k] = a;                             \
+                k++;                                                           \
+            }                                                                  \
+            if (!c->out)                                                       \
+                c->offsets[t] = k;                                             \
+        }                                                                      \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, init_reserved)(name * v,                 \
-                                                     size_t reserved) {        \
-        v->size = 0;                                                           \
-        v->capacity = reserved;                                                \
-        if (!(v->data = malloc(sizeof(type) * v->capacity))) {                 \
+    static inline void _VCFN(fn_name, op)(name v, name * out, void *ctx) {     \
+        out->size = 0;                                                         \
+        _VCFN(fn_name, grow)(out, v.size);                                     \
+        out->size =                                                            \
+            _VCFN(fn_name, op##_range)(v.data, v.size, out->data, ctx);        \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_##op)(                          \
+        name v, name * out, void *ctx, size_t threads) {                       \
+        threads = _vec_thread_count(threads);                                  \
+        if (threads < 2 || v.size < VEC_PARALLEL_THRESHOLD) {                  \
+            _VCFN(fn_name, op)(v, out, ctx);                                   \
+            return;                                                            \
+        }                                                                      \
+        out->size = 0;                                                         \
+        _VCFN(fn_name, grow)(out, v.size);                                     \
+        _VCFN(fn_name, op##_ctx) c = {v.data, NULL, v.size, threads, NULL,     \
+                                       ctx};                                   \
+        if (!(c.offsets = (size_t *)VEC_MALLOC(sizeof(size_t) * threads))) {   \
             perror("malloc failed");                                           \
             exit(EXIT_FAILURE);                                                \
         }                                                                      \
+        _vec_parallel_for(threads, threads, _VCFN(fn_name, op##_task), &c);    \
+        size_t total = 0;                                                      \
+        for (size_t t = 0; t < threads; t++) {                                 \
+            size_t count = c.offsets[t];                                       \
+            c.offsets[t] = total;                                              \
+            total += count;                                                    \
+        }                                                                      \
+        c.out = out->data;                                                     \
+        _vec_parallel_for(threads, threads, _VCFN(fn_name, op##_task), &c);    \
+        out->size = total;                                                     \
+        VEC_FREE(c.offsets);                                                   \
+    }
+
+// `name_op(v, ctx)` runs `st` for every element.
+#define vec_define_ops_for_each(type, name, op, st)                            \
+    vec_define_ops_for_each2(type, name, name, op, st)
+#define vec_define_ops_for_each2(type, name, fn_name, op, st)                  \
+    static inline void _VCFN(fn_name, op##_range)(                             \
+        const type *d, size_t n, void *ctx) {                                  \
+        (void)ctx;                                                             \
+        for (size_t i = 0; i < n; i++) {                                       \
+            type a = d[i];                                                     \
+            st;                                                                \
+        }                                                                      \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, init)(name * v) {                        \
-        _VCFN(fn_name, init_reserved)(v, 4);                                   \
+    typedef struct {                                                           \
+        const type *data;                                                      \
+        void *ctx;                                                             \
+    } _VCFN(fn_name, op##_ctx);                                                \
+                                                                               \
+    static inline void _VCFN(fn_name, op##_task)(void *arg, size_t begin,      \
+                                                 size_t end) {                 \
+        _VCFN(fn_name, op##_ctx) *c = (_VCFN(fn_name, op##_ctx) *)arg;         \
+        _VCFN(fn_name, op##_range)(c->data + begin, end - begin, c->ctx);      \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, realloc)(name * v, size_t n) {           \
-        if (n == v->capacity)                                                  \
+    static inline void _VCFN(fn_name, op)(name v, void *ctx) {                 \
+        _VCFN(fn_name, op##_range)(v.data, v.size, ctx);                       \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, parallel_##op)(                          \
+        name v, void *ctx, size_t threads) {                                   \
+        threads = _vec_thread_count(threads);                                  \
+        if (threads < 2 || v.size < VEC_PARALLEL_THRESHOLD) {                  \
+            _VCFN(fn_name, op##_range)(v.data, v.size, ctx);                   \
             return;                                                            \
-        if (n == 0) {                                                          \
-            free(v->data);                                                     \
-            v->data = NULL;                                                    \
-        } else if (v->data == NULL) {                                          \
-            v->data = malloc(sizeof(type) * n);                                \
-            if (!v->data) {                                                    \
-                perror("malloc failed");                                       \
-                exit(EXIT_FAILURE);                                            \
-            }                                                                  \
-        } else {                                                               \
-            type *newData = realloc(v->data, sizeof(type) * n);                \
-            if (!newData) {                                                    \
-                perror("realloc failed");                                      \
-                exit(EXIT_FAILURE);                                            \
-            }                                                                  \
-            v->data = newData;                                                 \
         }                                                                      \
-        v->capacity = n;                                                       \
-        if (v->size > n)                                                       \
-            v->size = n;                                                       \
+        _VCFN(fn_name, op##_ctx) c = {v.data, ctx};                            \
+        _vec_parallel_for(v.size, threads, _VCFN(fn_name, op##_task), &c);     \
+    }
+
+// Minimum and maximum by `comp_st`, which works like vec_define_sort's.
+// `min` and `max` exit on an empty vector, `argmin` and `argmax` return the
+// index of the first minimum or maximum, VEC_NPOS on an empty vector. Each
+// one has a `name_parallel_...(v, threads)` variant like the ops above, which
+// finds the extreme of every part and keeps the first of them, so it gives the
+// same result as the serial one.
+#define vec_define_ops_minmax(type, name, comp_st)                             \
+    vec_define_ops_minmax2(type, name, name, comp_st)
+#define vec_define_ops_minmax2(type, name, fn_name, comp_st)                   \
+    static inline int _VCFN(fn_name, minmax_cmp)(const type *a_ptr,            \
+                                                 const type *b_ptr) {          \
+        const type a = *a_ptr;                                                 \
+        const type b = *b_ptr;                                                 \
+        return (comp_st);                                                      \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, push)(name * v, type x) {                \
-        if (v->size >= v->capacity)                                            \
-            _VCFN(fn_name, realloc)(                                           \
-                v, v->capacity > 1 ? (v->capacity + (v->capacity >> 1)) : 2);  \
-        v->data[v->size++] = x;                                                \
+    /* Index of the first minimum (or maximum) of `n` > 0 elements. */         \
+    static inline size_t _VCFN(fn_name, arg_range)(const type *_VCRESTRICT d,  \
+                                                   size_t n, bool max) {       \
+        size_t best = 0;                                                       \
+        for (size_t i = 1; i < n; i++) {                                       \
+            int c = _VCFN(fn_name, minmax_cmp)(&d[i], &d[best]);               \
+            if (max ? c > 0 : c < 0)                                           \
+                best = i;                                                      \
+        }                                                                      \
+        return best;                                                           \
     }                                                                          \
                                                                                \
-    static inline type _VCFN(fn_name, pop)(name * v) {                         \
-        return v->data[v->size == 0 ? 0 : --v->size];                          \
+    typedef struct {                                                           \
+        const type *data;                                                      \
+        size_t n, parts;                                                       \
+        size_t *best;                                                          \
+        bool max;                                                              \
+    } _VCFN(fn_name, arg_ctx);                                                 \
+                                                                               \
+    static inline void _VCFN(fn_name, arg_task)(void *arg, size_t begin,       \
+                                                size_t end) {                  \
+        _VCFN(fn_name, arg_ctx) *c = (_VCFN(fn_name, arg_ctx) *)arg;           \
+        for (size_t t = begin; t < end; t++) {                                 \
+            size_t s, e;                                                       \
+            _vec_range(c->n, c->parts, t, &s, &e);                             \
+            c->best[t] = s + _VCFN(fn_name, arg_range)(c->data + s, e - s,     \
+                                                       c->max);                \
+        }                                                                      \
     }                                                                          \
                                                                                \
-    static inline type *_VCFN(fn_name, back)(name v) {                         \
-        return v.size == 0 ? NULL : &v.data[v.size - 1];                       \
+    static inline size_t _VCFN(fn_name, parallel_arg)(name v, size_t threads,  \
+                                                      bool max) {              \
+        if (v.size == 0)                                                       \
+            return VEC_NPOS;                                                   \
+        threads = _vec_thread_count(threads);                                  \
+        if (threads < 2 || v.size < VEC_PARALLEL_THRESHOLD)                    \
+            return _VCFN(fn_name, arg_range)(v.data, v.size, max);             \
+        size_t best[VEC_MAX_THREADS];                                          \
+        _VCFN(fn_name, arg_ctx) c = {v.data, v.size, threads, best, max};      \
+        _vec_parallel_for(threads, threads, _VCFN(fn_name, arg_task), &c);     \
+        size_t i = best[0];                                                    \
+        for (size_t t = 1; t < threads; t++) {                                 \
+            int cmp =                                                          \
+                _VCFN(fn_name, minmax_cmp)(&v.data[best[t]], &v.data[i]);      \
+            if (max ? cmp > 0 : cmp < 0)                                       \
+                i = best[t];                                                   \
+        }                                                                      \
+        return i;                                                              \
     }                                                                          \
                                                                                \
-    static inline bool _VCFN(fn_name, empty)(name v) {                         \
-        return v.size == 0;                                                    \
+    static inline size_t _VCFN(fn_name, argmin)(name v) {                      \
+        return v.size == 0 ? VEC_NPOS                                          \
+                           : _VCFN(fn_name, arg_range)(v.data, v.size, false); \
     }                                                                          \
                                                                                \
-    static inline type _VCFN(fn_name, at)(name v, size_t i) {                  \
-        if (i < 0 || i >= v.size) {                                            \
-            perror("vector index out of bounds");                              \
+    static inline size_t _VCFN(fn_name, argmax)(name v) {                      \
+        return v.size == 0 ? VEC_NPOS                                          \
+                           : _VCFN(fn_name, arg_range)(v.data, v.size, true);  \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, parallel_argmin)(name v,               \
+                                                         size_t threads) {     \
+        return _VCFN(fn_name, parallel_arg)(v, threads, false);                \
+    }                                                                          \
+                                                                               \
+    static inline size_t _VCFN(fn_name, parallel_argmax)(name v,               \
+                                                         size_t threads) {     \
+        return _VCFN(fn_name, parallel_arg)(v, threads, true);                 \
+    }                                                                          \
+                                                                               \
+    static inline type _VCFN(fn_name, min)(name v) {                           \
+        if (v.size == 0) {                                                     \
+            perror("vector is empty");                                         \
             exit(EXIT_FAILURE);                                                \
         }                                                                      \
                                                                                \
-        return v.data[i];                                                      \
+        const type *_VCRESTRICT d = v.data;                                    \
+        type m = d[0];                                                         \
+        for (size_t i = 1; i < v.size; i++)                                    \
+            m = _VCFN(fn_name, minmax_cmp)(&d[i], &m) < 0 ? d[i] : m;          \
+        return m;                                                              \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, set)(name * v, size_t i, type x) {       \
-        if (i < 0 || i >= v->size) {                                           \
-            perror("vector index out of bounds");                              \
+    static inline type _VCFN(fn_name, max)(name v) {                           \
+        if (v.size == 0) {                                                     \
+            perror("vector is empty");                                         \
             exit(EXIT_FAILURE);                                                \
         }                                                                      \
                                                                                \
-        v->data[i] = x;                                                        \
+        const type *_VCRESTRICT d = v.data;                                    \
+        type m = d[0];                                                         \
+        for (size_t i = 1; i < v.size; i++)                                    \
+            m = _VCFN(fn_name, minmax_cmp)(&d[i], &m) > 0 ? d[i] : m;          \
+        return m;                                                              \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, shrink)(name * v) {                      \
-        if (v->size != v->capacity)                                            \
-            _VCFN(fn_name, realloc)(v, v->size);                               \
-    }                                                                          \
+    static inline type _VCFN(fn_name, parallel_min)(name v, size_t threads) {  \
+        if (v.size == 0) {                                                     \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
+        }                                                                      \
                                                                                \
-    static inline void _VCFN(fn_name, reserve)(name * v, size_t n) {           \
-        if (n > v->capacity)                                                   \
-            _VCFN(fn_name, realloc)(v, n);                                     \
+        return v.data[_VCFN(fn_name, parallel_arg)(v, threads, false)];        \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, reverse)(name * v) {                     \
-        for (size_t i = 0; i < v->size / 2; i++) {                             \
-            type tmp = v->data[i];                                             \
-            v->data[i] = v->data[v->size - 1 - i];                             \
-            v->data[v->size - 1 - i] = tmp;                                    \
+    static inline type _VCFN(fn_name, parallel_max)(name v, size_t threads) {  \
+        if (v.size == 0) {                                                     \
+            perror("vector is empty");                                         \
+            exit(EXIT_FAILURE);                                                \
         }                                                                      \
+                                                                               \
+        return v.data[_VCFN(fn_name, parallel_arg)(v, threads, true)];         \
     }
 
-#define vec_define_contains(type, name, eq_st)                                 \
-    vec_define_contains2(type, name, name, eq_st)
-#define vec_define_contains2(type, name, fn_name, eq_st)                       \
-    static inline bool _VCFN(fn_name, contains)(name v, type b) {              \
+// Growable byte buffer the format functions write to. A buffer initialized
+// with vec_buf_init_file or vec_buf_init_fd writes its contents to the file
+// in large blocks as it fills up, one initialized with vec_buf_init keeps
+// everything. Buffers can be reused with vec_buf_clear.
+#ifndef VEC_BUF_FLUSH
+#define VEC_BUF_FLUSH ((size_t)1 << 16)
+#endif
+
+typedef struct {
+    char *data;
+    size_t size, capacity;
+    FILE *file;
+    int fd;
+} vec_buf;
+
+static inline void vec_buf_init(vec_buf *b) {
+    b->data = NULL;
+    b->size = 0;
+    b->capacity = 0;
+    b->file = NULL;
+    b->fd = -1;
+}
+
+static inline void vec_buf_init_file(vec_buf *b, FILE *file) {
+    vec_buf_init(b);
+    b->file = file;
+}
+
+static inline void vec_buf_init_fd(vec_buf *b, int fd) {
+    vec_buf_init(b);
+    b->fd = fd;
+}
+
+static inline void vec_buf_free(vec_buf *b) {
+    VEC_FREE(b->data);
+    b->data = NULL;
+    b->size = 0;
+    b->capacity = 0;
+}
+
+static inline void vec_buf_clear(vec_buf *b) {
+    b->size = 0;
+}
+
+// Makes room for `n` more bytes and one terminating null byte.
+static inline char *vec_buf_reserve(vec_buf *b, size_t n) {
+    if (b->size + n + 1 > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity * 2 : 256;
+        while (capacity < b->size + n + 1)
+            capacity *= 2;
+        char *data = (char *)VEC_REALLOC(b->data, capacity);
+        if (!data) {
+            perror("realloc failed");
+            exit(EXIT_FAILURE);
+        }
+        b->data = data;
+        b->capacity = capacity;
+    }
+    return b->data + b->size;
+}
+
+static inline void vec_buf_write(vec_buf *b, const void *ptr, size_t n) {
+    memcpy(vec_buf_reserve(b, n), ptr, n);
+    b->size += n;
+}
+
+static inline void vec_buf_putc(vec_buf *b, char c) {
+    *vec_buf_reserve(b, 1) = c;
+    b->size++;
+}
+
+static inline void vec_buf_puts(vec_buf *b, const char *s) {
+    vec_buf_write(b, s, strlen(s));
+}
+
+static inline void vec_buf_indent(vec_buf *b, size_t n) {
+    memset(vec_buf_reserve(b, n), ' ', n);
+    b->size += n;
+}
+
+static inline void vec_buf_printf(vec_buf *b, const char *fmt, ...) {
+    va_list args, copy;
+    va_start(args, fmt);
+    va_copy(copy, args);
+    char *dst = vec_buf_reserve(b, 0);
+    size_t room = b->capacity - b->size;
+    int n = vsnprintf(dst, room, fmt, args);
+    if (n >= 0 && (size_t)n >= room) {
+        vec_buf_reserve(b, (size_t)n);
+        vsnprintf(b->data + b->size, (size_t)n + 1, fmt, copy);
+    }
+    if (n > 0)
+        b->size += (size_t)n;
+    va_end(copy);
+    va_end(args);
+}
+
+static const char _vec_digits[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+// Writes integers in decimal two digits at a time, without printf.
+static inline void vec_buf_u64(vec_buf *b, uint64_t x) {
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    while (x >= 100) {
+        size_t d = (size_t)(x % 100) * 2;
+        x /= 100;
+        *--p = _vec_digits[d + 1];
+        *--p = _vec_digits[d];
+    }
+    if (x < 10) {
+        *--p = (char)('0' + x);
+    } else {
+        *--p = _vec_digits[x * 2 + 1];
+        *--p = _vec_digits[x * 2];
+    }
+    vec_buf_write(b, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+static inline void vec_buf_i64(vec_buf *b, int64_t x) {
+    if (x < 0) {
+        vec_buf_putc(b, '-');
+        vec_buf_u64(b, (uint64_t)0 - (uint64_t)x);
+        return;
+    }
+    vec_buf_u64(b, (uint64_t)x);
+}
+
+// Writes the contents to the file the buffer was initialized with and empties
+// it. Returns false if writing failed, buffers without a file keep their
+// contents and return true.
+static inline bool vec_buf_flush(vec_buf *b) {
+    if (b->file) {
+        bool ok = fwrite(b->data, 1, b->size, b->file) == b->size;
+        b->size = 0;
+        return ok;
+    }
+#ifdef _VC_HAS_MMAP
+    if (b->fd >= 0) {
+        const char *p = b->data;
+        size_t left = b->size;
+        b->size = 0;
+        while (left > 0) {
+            ssize_t n = write(b->fd, p, left);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            p += n;
+            left -= (size_t)n;
+        }
+    }
+#endif
+    return true;
+}
+
+// Called between elements, flushes buffers with a file once they are big.
+static inline void _vec_buf_step(vec_buf *b) {
+    if ((b->file || b->fd >= 0) && b->size >= VEC_BUF_FLUSH)
+        vec_buf_flush(b);
+}
+
+// Whether `fmt` is a single integer conversion without flags or width, like
+// "%d" or "%llu", which vec_buf_i64 and vec_buf_u64 print the same way.
+static inline bool _vec_fmt_is_plain_int(const char *fmt) {
+    if (*fmt++ != '%')
+        return false;
+    while (*fmt == 'h' || *fmt == 'l' || *fmt == 'j' || *fmt == 'z' ||
+           *fmt == 't')
+        fmt++;
+    return (*fmt == 'd' || *fmt == 'i' || *fmt == 'u') && fmt[1] == '\0';
+}
+
+// Writes a primitive number `a` formatted with the printf format `fmt`.
+#define _VCBUF_PRIMITIVE(buf, type, fmt, a)                                    \
+    (!_VCISFLOAT(type) && _vec_fmt_is_plain_int(fmt)                           \
+         ? (_VCISSIGNED(type) ? vec_buf_i64(buf, (int64_t)(a))                 \
+                              : vec_buf_u64(buf, (uint64_t)(a)))               \
+         : vec_buf_printf(buf, fmt, a))
+
+// Buffered version of vec_define_print: `format_st` writes the element `a` to
+// `buf` with the vec_buf functions, and it gets the same brackets, commas and
+// indentation print gives. `print`, `print_indent`, `fprint` and `print_fd`
+// format the vector into a buffer that's written out in large blocks,
+// `to_string` returns a null terminated string to be freed with VEC_FREE, and
+// `format` appends to a buffer you own. `format_st` can call the
+// `format_indent` of another vector with `indent` to nest them.
+#define vec_define_format(type, name, format_st)                               \
+    vec_define_format2(type, name, name, format_st, 1)
+#define vec_define_format2(type, name, fn_name, format_st, newline)            \
+    static inline void _VCFN(fn_name, format_indent)(vec_buf * buf, name v,    \
+                                                     size_t indent) {          \
+        if (!v.data) {                                                         \
+            vec_buf_puts(buf, #type "[]");                                     \
+            return;                                                            \
+        }                                                                      \
+        vec_buf_puts(buf, #type "[");                                          \
+        if (v.size == 0) {                                                     \
+            vec_buf_putc(buf, ']');                                            \
+            return;                                                            \
+        }                                                                      \
+        if (newline)                                                           \
+            vec_buf_putc(buf, '\n');                                           \
+        indent++;                                                              \
         for (size_t i = 0; i < v.size; i++) {                                  \
+            vec_buf_indent(buf, indent * _VCINDENT_MULT);                      \
             type a = v.data[i];                                                \
-            if (eq_st)                                                         \
-                return true;                                                   \
+            format_st;                                                         \
+            if (i < v.size - 1)                                                \
+                vec_buf_putc(buf, ',');                                        \
+            if (newline)                                                       \
+                vec_buf_putc(buf, '\n');                                       \
+            _vec_buf_step(buf);                                                \
         }                                                                      \
-        return false;                                                          \
-    }
-
-#define vec_define_sort(type, name, comp_st)                                   \
-    vec_define_sort2(type, name, name, comp_st)
-#define vec_define_sort2(type, name, fn_name, comp_st)                         \
-    static int _VCFN(fn_name, sort_adapter)(const void *a_ptr,                 \
-                                            const void *b_ptr) {               \
-        const type a = *(const type *)a_ptr;                                   \
-        const type b = *(const type *)b_ptr;                                   \
-        return (comp_st);                                                      \
+        vec_buf_indent(buf, (indent <= 1 ? 0 : indent - 2) * _VCINDENT_MULT);  \
+        vec_buf_putc(buf, ']');                                                \
     }                                                                          \
                                                                                \
-    static int _VCFN(fn_name, sort_adapter_rev)(const void *a_ptr,             \
-                                                const void *b_ptr) {           \
-        const type a = *(const type *)a_ptr;                                   \
-        const type b = *(const type *)b_ptr;                                   \
-        return -(comp_st);                                                     \
+    static inline void _VCFN(fn_name, format)(vec_buf * buf, name v) {         \
+        _VCFN(fn_name, format_indent)(buf, v, 0);                              \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, sort)(name * v) {                        \
-        qsort(v->data, v->size, sizeof(type), _VCFN(fn_name, sort_adapter));   \
+    static inline char *_VCFN(fn_name, to_string)(name v) {                    \
+        vec_buf buf;                                                           \
+        vec_buf_init(&buf);                                                    \
+        _VCFN(fn_name, format)(&buf, v);                                       \
+        *vec_buf_reserve(&buf, 0) = '\0';                                      \
+        return buf.data;                                                       \
     }                                                                          \
                                                                                \
-    static inline void _VCFN(fn_name, sort_reversed)(name * v) {               \
-        qsort(v->data, v->size, sizeof(type),                                  \
-              _VCFN(fn_name, sort_adapter_rev));                               \
+    static inline bool _VCFN(fn_name, fprint_indent)(FILE * file, name v,      \
+                                                     size_t indent) {          \
+        vec_buf buf;                                                           \
+        vec_buf_init_file(&buf, file);                                         \
+        _VCFN(fn_name, format_indent)(&buf, v, indent);                        \
+        bool ok = vec_buf_flush(&buf);                                         \
+        vec_buf_free(&buf);                                                    \
+        return ok;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, fprint)(FILE * file, name v) {           \
+        return _VCFN(fn_name, fprint_indent)(file, v, 0);                      \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, print_fd)(name v, int fd) {              \
+        vec_buf buf;                                                           \
+        vec_buf_init_fd(&buf, fd);                                             \
+        _VCFN(fn_name, format)(&buf, v);                                       \
+        bool ok = vec_buf_flush(&buf);                                         \
+        vec_buf_free(&buf);                                                    \
+        return ok;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, print_indent)(name v, size_t indent) {   \
+        _VCFN(fn_name, fprint_indent)(stdout, v, indent);                      \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, print)(name v) {                         \
+        _VCFN(fn_name, print_indent)(v, 0);                                    \
     }
 
 #define vec_define_print(type, name, print_st)                                 \
@@ -206,23 +4254,288 @@
         _VCFN(fn_name, print_indent)(v, 0);                                    \
     }
 
+#ifdef _VC_HAS_MMAP
+// Binary files written by vec_define_io start with this header, the elements
+// follow right after it in the byte order of the machine that wrote them.
+typedef struct {
+    char magic[8];
+    uint32_t version, elem_size;
+    uint64_t size, checksum;
+} vec_io_header;
+
+#define _VCIO_MAGIC "vec.hbin"
+#define _VCIO_VERSION 1
+// Bytes the streaming reader asks the file descriptor for at once.
+#ifndef VEC_IO_CHUNK
+#define VEC_IO_CHUNK ((size_t)1 << 16)
+#endif
+// VEC_IO_CHUNK in elements, at least one for elements bigger than it.
+#define _VCIO_CHUNK(type)                                                      \
+    (VEC_IO_CHUNK < sizeof(type) ? (size_t)1 : VEC_IO_CHUNK / sizeof(type))
+
+// 64 bit checksum of the elements, four independent lanes keep it close to
+// memory speed.
+static inline uint64_t _vec_checksum(const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h[4] = {0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+                     0x165667b19e3779f9ULL, 0x27d4eb2f165667c5ULL};
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        for (size_t l = 0; l < 4; l++) {
+            uint64_t w;
+            memcpy(&w, p + i + l * 8, 8);
+            h[l] = (h[l] ^ w) * 0x100000001b3ULL;
+            h[l] ^= h[l] >> 29;
+        }
+    }
+    uint64_t r = len;
+    for (size_t l = 0; l < 4; l++)
+        r = _vec_hash_mix(r ^ h[l]);
+    for (; i < len; i++)
+        r = (r ^ p[i]) * 0x100000001b3ULL;
+    return _vec_hash_mix(r);
+}
+
+// Writes every buffer completely, retrying partial and interrupted writes.
+static inline bool _vec_writev_all(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        size_t left = (size_t)n;
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+// Reads exactly `len` bytes, failing with EINVAL if the input ends before.
+static inline bool _vec_read_all(int fd, void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (n == 0) {
+            errno = EINVAL;
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Stores in `bytes` what is left of `fd` after the current offset. Returns
+// false when that isn't known, for pipes, sockets and terminals.
+static inline bool _vec_io_remaining(int fd, uint64_t *bytes) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return false;
+    off_t at = lseek(fd, 0, SEEK_CUR);
+    if (at < 0)
+        return false;
+    *bytes = st.st_size > at ? (uint64_t)(st.st_size - at) : 0;
+    return true;
+}
+
+// Binary I/O for vectors of plain data. `write_fd` and `write_file` save the
+// vector with a vec_io_header in one writev call and `read_fd` and
+// `read_file` load it back, replacing the contents of the vector. They
+// return false and set errno on failure, EINVAL when the data isn't a vector
+// of this type, is shorter than its header says or the checksum doesn't
+// match. A failed read leaves the vector empty. The header count is checked
+// against the size of regular files and other inputs are read VEC_IO_CHUNK
+// bytes at a time, so a corrupt header can't make read_fd allocate more than
+// the input holds.
+// `write_raw_fd` writes only the elements, and `read_stream` reads elements
+// until the end of the input without knowing their count, for pipes and
+// sockets, waiting in poll while a non-blocking descriptor has no data.
+// `name_reader` does the same one read call at a time: `reader_step` returns
+// the number of elements it appended, 0 if the read would block, and -1 on
+// errors. `eof` is set once the input ended.
+#define vec_define_io(type, name) vec_define_io2(type, name, name)
+#define vec_define_io2(type, name, fn_name)                                    \
+    typedef struct {                                                           \
+        int fd;                                                                \
+        bool eof;                                                              \
+        size_t pending;                                                        \
+        unsigned char partial[sizeof(type)];                                   \
+    } name##_reader;                                                           \
+                                                                               \
+    static inline bool _VCFN(fn_name, write_fd)(name v, int fd) {              \
+        vec_io_header header;                                                  \
+        memset(&header, 0, sizeof(header));                                    \
+        memcpy(header.magic, _VCIO_MAGIC, sizeof(header.magic));               \
+        header.version = _VCIO_VERSION;                                        \
+        header.elem_size = (uint32_t)sizeof(type);                             \
+        header.size = v.size;                                                  \
+        header.checksum = _vec_checksum(v.data, sizeof(type) * v.size);        \
+        struct iovec iov[2];                                                   \
+        iov[0].iov_base = &header;                                             \
+        iov[0].iov_len = sizeof(header);                                       \
+        iov[1].iov_base = v.data;                                              \
+        iov[1].iov_len = sizeof(type) * v.size;                                \
+        return _vec_writev_all(fd, iov, v.size ? 2 : 1);                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, write_raw_fd)(name v, int fd) {          \
+        struct iovec iov;                                                      \
+        iov.iov_base = v.data;                                                 \
+        iov.iov_len = sizeof(type) * v.size;                                   \
+        return _vec_writev_all(fd, &iov, v.size ? 1 : 0);                      \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, write_file)(name v, const char *path) {  \
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);               \
+        if (fd < 0)                                                            \
+            return false;                                                      \
+        bool ok = _VCFN(fn_name, write_fd)(v, fd);                             \
+        int saved = errno;                                                     \
+        if (close(fd) != 0 && ok)                                              \
+            return false;                                                      \
+        errno = saved;                                                         \
+        return ok;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, read_fd)(name * v, int fd) {             \
+        v->size = 0;                                                           \
+        name##_detach(v);                                                      \
+        vec_io_header header;                                                  \
+        if (!_vec_read_all(fd, &header, sizeof(header)))                       \
+            return false;                                                      \
+        if (memcmp(header.magic, _VCIO_MAGIC, sizeof(header.magic)) != 0 ||    \
+            header.version != _VCIO_VERSION ||                                 \
+            header.elem_size != sizeof(type) ||                                \
+            header.size > SIZE_MAX / sizeof(type)) {                           \
+            errno = EINVAL;                                                    \
+            return false;                                                      \
+        }                                                                      \
+        uint64_t left;                                                         \
+        bool known = _vec_io_remaining(fd, &left);                             \
+        if (known && left / sizeof(type) < header.size) {                      \
+            errno = EINVAL;                                                    \
+            return false;                                                      \
+        }                                                                      \
+        size_t size = (size_t)header.size;                                     \
+        if (known)                                                             \
+            _VCFN(fn_name, reserve)(v, size);                                  \
+        while (v->size < size) {                                               \
+            size_t n = size - v->size;                                         \
+            if (!known && n > _VCIO_CHUNK(type))                               \
+                n = _VCIO_CHUNK(type);                                         \
+            _VCFN(fn_name, grow)(v, n);                                        \
+            if (!_vec_read_all(fd, v->data + v->size, sizeof(type) * n)) {     \
+                v->size = 0;                                                   \
+                return false;                                                  \
+            }                                                                  \
+            v->size += n;                                                      \
+        }                                                                      \
+        if (_vec_checksum(v->data, sizeof(type) * size) != header.checksum) {  \
+            v->size = 0;                                                       \
+            errno = EINVAL;                                                    \
+            return false;                                                      \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, read_file)(name * v, const char *path) { \
+        int fd = open(path, O_RDONLY);                                         \
+        if (fd < 0)                                                            \
+            return false;                                                      \
+        bool ok = _VCFN(fn_name, read_fd)(v, fd);                              \
+        int saved = errno;                                                     \
+        close(fd);                                                             \
+        errno = saved;                                                         \
+        return ok;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reader_init)(name##_reader * r,          \
+                                                   int fd) {                   \
+        r->fd = fd;                                                            \
+        r->eof = false;                                                        \
+        r->pending = 0;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline ssize_t _VCFN(fn_name, reader_step)(name * v,                \
+                                                      name##_reader * r) {     \
+        _VCFN(fn_name, grow)(v, _VCIO_CHUNK(type) + 1);                        \
+        char *dst = (char *)(v->data + v->size);                               \
+        memcpy(dst, r->partial, r->pending);                                   \
+        size_t room = sizeof(type) * (v->capacity - v->size) - r->pending;     \
+        ssize_t n = read(r->fd, dst + r->pending, room);                       \
+        if (n < 0) {                                                           \
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)     \
+                return 0;                                                      \
+            return -1;                                                         \
+        }                                                                      \
+        if (n == 0) {                                                          \
+            r->eof = true;                                                     \
+            if (r->pending) {                                                  \
+                errno = EINVAL;                                                \
+                return -1;                                                     \
+            }                                                                  \
+            return 0;                                                          \
+        }                                                                      \
+        size_t total = r->pending + (size_t)n;                                 \
+        size_t count = total / sizeof(type);                                   \
+        r->pending = total % sizeof(type);                                     \
+        memcpy(r->partial, dst + sizeof(type) * count, r->pending);            \
+        v->size += count;                                                      \
+        return (ssize_t)count;                                                 \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, read_stream)(name * v, int fd) {         \
+        name##_reader r;                                                       \
+        _VCFN(fn_name, reader_init)(&r, fd);                                   \
+        while (!r.eof) {                                                       \
+            ssize_t n = _VCFN(fn_name, reader_step)(v, &r);                    \
+            if (n < 0)                                                         \
+                return false;                                                  \
+            if (n > 0 || r.eof)                                                \
+                continue;                                                      \
+            struct pollfd p = {fd, POLLIN, 0};                                 \
+            if (poll(&p, 1, -1) < 0 && errno != EINTR)                         \
+                return false;                                                  \
+        }                                                                      \
+        return true;                                                           \
+    }
+#endif // _VC_HAS_MMAP
+
 #define vec_define_free_simple(type, name)                                     \
+    vec_define_free_simple2(type, name, name)
+#define vec_define_free_simple2(type, name, fn_name)                           \
     static inline void _VCFN(fn_name, clear)(name * v) {                       \
         if (!v->data)                                                          \
             return;                                                            \
-        free(v->data);                                                         \
-        v->data = NULL;                                                        \
+        _VCFN(fn_name, realloc)(v, 0);                                         \
+        v->size = 0;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reset)(name * v) {                       \
         v->size = 0;                                                           \
-        v->capacity = 0;                                                       \
     }                                                                          \
                                                                                \
     static inline void _VCFN(fn_name, resize)(name * v, size_t n,              \
                                               type def_val) {                  \
-        if (n > v->capacity) {                                                 \
+        name##_detach(v);                                                      \
+        if (n > v->capacity)                                                   \
             _VCFN(fn_name, realloc)(v, n);                                     \
-            while (v->size < n) {                                              \
-                v->data[v->size++] = def_val;                                  \
-            }                                                                  \
+        while (v->size < n) {                                                  \
+            v->data[v->size++] = def_val;                                      \
         }                                                                      \
         v->size = n;                                                           \
     }
@@ -233,27 +4546,81 @@
     static inline void _VCFN(fn_name, clear)(name * v) {                       \
         if (!v->data)                                                          \
             return;                                                            \
+        /* A view or a clone only drops its reference. */                      \
+        if (name##_owns_elements(v)) {                                         \
+            for (size_t i = 0; i < v->size; i++) {                             \
+                type a = v->data[i];                                           \
+                free_st;                                                       \
+            }                                                                  \
+        }                                                                      \
+        _VCFN(fn_name, realloc)(v, 0);                                         \
+        v->size = 0;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, reset)(name * v) {                       \
+        if (!name##_owns_elements(v)) {                                        \
+            /* Swaps the shared buffer for an empty one of its own. */         \
+            v->size = 0;                                                       \
+            name##_detach(v);                                                  \
+            return;                                                            \
+        }                                                                      \
         for (size_t i = 0; i < v->size; i++) {                                 \
             type a = v->data[i];                                               \
             free_st;                                                           \
         }                                                                      \
-        free(v->data);                                                         \
-        v->data = NULL;                                                        \
         v->size = 0;                                                           \
-        v->capacity = 0;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline bool _VCFN(fn_name, clear_step)(name * v, size_t budget) {   \
+        if (!name##_owns_elements(v)) {                                        \
+            _VCFN(fn_name, clear)(v);                                          \
+            return true;                                                       \
+        }                                                                      \
+        for (; budget > 0 && v->size > 0; budget--) {                          \
+            type a = v->data[--v->size];                                       \
+            free_st;                                                           \
+        }                                                                      \
+        if (v->size > 0)                                                       \
+            return false;                                                      \
+        if (v->data)                                                           \
+            _VCFN(fn_name, realloc)(v, 0);                                     \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, clear_task)(void *arg) {                 \
+        _VCFN(fn_name, clear)((name *)arg);                                    \
+        VEC_FREE(arg);                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void _VCFN(fn_name, clear_deferred)(name * v) {              \
+        name *dead;                                                            \
+        if (v->size < VEC_DEFERRED_THRESHOLD || !name##_owns_elements(v) ||    \
+            !(dead = (name *)VEC_MALLOC(sizeof(name)))) {                      \
+            _VCFN(fn_name, clear)(v);                                          \
+            return;                                                            \
+        }                                                                      \
+        if (!_VCFN(fn_name, take)(v, dead)) {                                  \
+            VEC_FREE(dead);                                                    \
+            _VCFN(fn_name, clear)(v);                                          \
+            return;                                                            \
+        }                                                                      \
+        if (!_vec_run_detached(_VCFN(fn_name, clear_task), dead))              \
+            _VCFN(fn_name, clear_task)(dead);                                  \
     }                                                                          \
                                                                                \
     static inline void _VCFN(fn_name, resize)(name * v, size_t n,              \
                                               type def_val) {                  \
-        if (n > v->capacity) {                                                 \
-            for (size_t i = n; i < v->size; i++) {                             \
-                type a = v->data[i];                                           \
-                free_st;                                                       \
-            }                                                                  \
+        /* The elements dropped from a shared buffer still belong to it. */    \
+        bool owner = name##_owns_elements(v);                                  \
+        name##_detach(v);                                                      \
+        for (size_t i = n; owner && i < v->size; i++) {                        \
+            type a = v->data[i];                                               \
+            free_st;                                                           \
+        }                                                                      \
+        if (n > v->capacity)                                                   \
             _VCFN(fn_name, realloc)(v, n);                                     \
-            while (v->size < n) {                                              \
-                v->data[v->size++] = def_val;                                  \
-            }                                                                  \
+        while (v->size < n) {                                                  \
+            v->data[v->size++] = def_val;                                      \
         }                                                                      \
         v->size = n;                                                           \
     }
@@ -270,9 +4637,10 @@
 
 #define vec_define_primitive(type, fmt)                                        \
     vec_define(type, type##s);                                                 \
-    vec_define_print(type, type##s, printf(fmt, a));                           \
-    vec_define_contains(type, type##s, a == b);                                \
-    vec_define_sort(type, type##s, a - b);                                     \
-    vec_Define_free(type, type##s);
+    vec_define_format(type, type##s, _VCBUF_PRIMITIVE(buf, type, fmt, a));     \
+    vec_define_search_primitive(type, type##s);                                \
+    vec_define_sort_radix(type, type##s);                                      \
+    vec_define_ops_minmax(type, type##s, (a > b) - (a < b));                   \
+    vec_define_free_simple(type, type##s);
 
 #endif // VEC_H_DEFINED
\ No newline at end of file
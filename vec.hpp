@@ -0,0 +1,359 @@
+#ifndef VEC_HPP_DEFINED
+#define VEC_HPP_DEFINED
+
+/*
+ *                     __
+ *  _   _____  _____  / /_
+ * | | / / _ \/ ___/ / __ \
+ * | |/ /  __/ /___ / / / /
+ * |___/\___/\___(_)_/ /_/
+ *
+ * vec.hpp - C++ companion of vec.h, needs C++17.
+ * Author: OguzhanUmutlu
+ * License: MIT
+ */
+
+#include "vec.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace vec {
+
+// Dynamic array with the same layout as a vec_define vector of T. The memory
+// comes from the same allocator, so a vector can be handed to the C functions
+// with `as` and a C vector can be used from C++ with `from`, without copying.
+// Trivially copyable elements are moved with memcpy and realloc, the others
+// are move constructed and destroyed one by one.
+template <typename T> class vector {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "vec::vector does not support over-aligned types");
+
+    size_t size_, capacity_;
+    T *data_;
+
+    static constexpr bool trivial = std::is_trivially_copyable<T>::value;
+
+    [[noreturn]] static void fail(const char *message) {
+        perror(message);
+        exit(EXIT_FAILURE);
+    }
+
+    static T *allocate(size_t n) {
+        T *p = static_cast<T *>(_vec_heap_alloc(sizeof(T) * n));
+        if (!p)
+            fail("malloc failed");
+        return p;
+    }
+
+    void destroy(size_t from) {
+        if constexpr (!std::is_trivially_destructible<T>::value)
+            for (size_t i = from; i < size_; i++)
+                data_[i].~T();
+    }
+
+    // Moves the elements to a buffer of `n` elements, n >= size.
+    void relocate(size_t n) {
+        if (n == capacity_)
+            return;
+        if (n == 0) {
+            _vec_heap_free(data_, sizeof(T) * capacity_);
+            data_ = nullptr;
+        } else if constexpr (trivial) {
+            T *p = static_cast<T *>(
+                data_ ? _vec_heap_realloc(data_, sizeof(T) * capacity_,
+                                          sizeof(T) * n)
+                      : _vec_heap_alloc(sizeof(T) * n));
+            if (!p)
+                fail("realloc failed");
+            data_ = p;
+        } else {
+            T *p = allocate(n);
+            for (size_t i = 0; i < size_; i++) {
+                ::new (static_cast<void *>(p + i)) T(std::move(data_[i]));
+                data_[i].~T();
+            }
+            _vec_heap_free(data_, sizeof(T) * capacity_);
+            data_ = p;
+        }
+        capacity_ = n;
+    }
+
+    template <typename C> static constexpr void check_layout() {
+        static_assert(std::is_same<decltype(C::data), T *>::value,
+                      "the vector does not hold elements of this type");
+        static_assert(sizeof(C) == sizeof(vector) && offsetof(C, size) == 0 &&
+                          offsetof(C, capacity) == sizeof(size_t) &&
+                          offsetof(C, data) == 2 * sizeof(size_t),
+                      "the vector does not have the vec_define layout");
+        static_assert(trivial, "only vectors of trivially copyable types can "
+                               "be shared with C");
+    }
+
+    size_t grown(size_t extra) const {
+        size_t capacity = _vec_grow_capacity(capacity_);
+        return capacity < size_ + extra ? size_ + extra : capacity;
+    }
+
+  public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    vector() noexcept : size_(0), capacity_(0), data_(nullptr) {}
+
+    explicit vector(size_t n) : vector() { resize(n); }
+
+    vector(size_t n, const T &value) : vector() { resize(n, value); }
+
+    vector(std::initializer_list<T> items) : vector() {
+        reserve(items.size());
+        for (const T &x : items)
+            ::new (static_cast<void *>(data_ + size_++)) T(x);
+    }
+
+    vector(const vector &other) : vector() {
+        reserve(other.size_);
+        if constexpr (trivial) {
+            if (other.size_)
+                memcpy(data_, other.data_, sizeof(T) * other.size_);
+            size_ = other.size_;
+        } else {
+            for (const T &x : other)
+                ::new (static_cast<void *>(data_ + size_++)) T(x);
+        }
+    }
+
+    vector(vector &&other) noexcept
+        : size_(other.size_), capacity_(other.capacity_), data_(other.data_) {
+        other.size_ = other.capacity_ = 0;
+        other.data_ = nullptr;
+    }
+
+    vector &operator=(const vector &other) {
+        if (this != &other) {
+            vector copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    vector &operator=(vector &&other) noexcept {
+        vector moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    ~vector() {
+        destroy(0);
+        _vec_heap_free(data_, sizeof(T) * capacity_);
+    }
+
+    // Views a vec_define vector of T as a vec::vector. `C` must be the struct
+    // generated by vec_define, vec_define2 or a struct with the same fields.
+    template <typename C> static vector &from(C &c) noexcept {
+        check_layout<C>();
+        return *reinterpret_cast<vector *>(&c);
+    }
+
+    // Views the vector as the vec_define vector `C` of the same type.
+    template <typename C> C &as() noexcept {
+        check_layout<C>();
+        return *reinterpret_cast<C *>(this);
+    }
+
+    void swap(vector &other) noexcept {
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(data_, other.data_);
+    }
+
+    size_t size() const noexcept { return size_; }
+    size_t capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+    T *data() noexcept { return data_; }
+    const T *data() const noexcept { return data_; }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    T &operator[](size_t i) noexcept { return data_[i]; }
+    const T &operator[](size_t i) const noexcept { return data_[i]; }
+
+    T &at(size_t i) {
+        if (i >= size_)
+            fail("vector index out of bounds");
+        return data_[i];
+    }
+
+    const T &at(size_t i) const {
+        if (i >= size_)
+            fail("vector index out of bounds");
+        return data_[i];
+    }
+
+    T &front() {
+        if (size_ == 0)
+            fail("vector is empty");
+        return data_[0];
+    }
+
+    const T &front() const {
+        if (size_ == 0)
+            fail("vector is empty");
+        return data_[0];
+    }
+
+    T &back() {
+        if (size_ == 0)
+            fail("vector is empty");
+        return data_[size_ - 1];
+    }
+
+    const T &back() const {
+        if (size_ == 0)
+            fail("vector is empty");
+        return data_[size_ - 1];
+    }
+
+    void reserve(size_t n) {
+        if (n > capacity_)
+            relocate(n);
+    }
+
+    void shrink_to_fit() { relocate(size_); }
+
+    // Destroys the elements and keeps the capacity.
+    void clear() noexcept {
+        destroy(0);
+        size_ = 0;
+    }
+
+    template <typename... Args> T &emplace_back(Args &&...args) {
+        if (size_ < capacity_) {
+            ::new (static_cast<void *>(data_ + size_))
+                T(std::forward<Args>(args)...);
+            return data_[size_++];
+        }
+        if constexpr (trivial) {
+            // The arguments may point into the buffer that is about to move.
+            T x(std::forward<Args>(args)...);
+            relocate(grown(1));
+            memcpy(static_cast<void *>(data_ + size_), &x, sizeof(T));
+        } else {
+            size_t capacity = grown(1);
+            T *p = allocate(capacity);
+            ::new (static_cast<void *>(p + size_))
+                T(std::forward<Args>(args)...);
+            for (size_t i = 0; i < size_; i++) {
+                ::new (static_cast<void *>(p + i)) T(std::move(data_[i]));
+                data_[i].~T();
+            }
+            _vec_heap_free(data_, sizeof(T) * capacity_);
+            data_ = p;
+            capacity_ = capacity;
+        }
+        return data_[size_++];
+    }
+
+    void push_back(const T &x) { emplace_back(x); }
+    void push_back(T &&x) { emplace_back(std::move(x)); }
+
+    T pop_back() {
+        if (size_ == 0)
+            fail("vector is empty");
+        T x(std::move(data_[size_ - 1]));
+        data_[--size_].~T();
+        return x;
+    }
+
+    void resize(size_t n) {
+        if (n <= size_) {
+            destroy(n);
+            size_ = n;
+            return;
+        }
+        reserve(n);
+        std::uninitialized_value_construct(data_ + size_, data_ + n);
+        size_ = n;
+    }
+
+    void resize(size_t n, const T &value) {
+        if (n <= size_) {
+            destroy(n);
+            size_ = n;
+            return;
+        }
+        if (n > capacity_) {
+            T copy(value);
+            relocate(n);
+            std::uninitialized_fill(data_ + size_, data_ + n, copy);
+        } else {
+            std::uninitialized_fill(data_ + size_, data_ + n, value);
+        }
+        size_ = n;
+    }
+
+    // Appends `n` elements, copied with memcpy when T is trivially copyable.
+    void append(const T *items, size_t n) {
+        if (n == 0)
+            return;
+        vector copy;
+        if (size_ + n > capacity_) {
+            if (items >= data_ && items < data_ + size_) {
+                copy.append(items, n);
+                items = copy.data_;
+            }
+            relocate(grown(n));
+        }
+        if constexpr (trivial)
+            memcpy(static_cast<void *>(data_ + size_), items, sizeof(T) * n);
+        else
+            std::uninitialized_copy(items, items + n, data_ + size_);
+        size_ += n;
+    }
+
+    void reverse() noexcept { std::reverse(begin(), end()); }
+
+    // The comparison and equality are template parameters, so the calls are
+    // inlined into the loops instead of going through function pointers.
+    template <typename Eq = std::equal_to<T>>
+    size_t find_index(const T &x, Eq eq = Eq()) const {
+        for (size_t i = 0; i < size_; i++)
+            if (eq(data_[i], x))
+                return i;
+        return VEC_NPOS;
+    }
+
+    template <typename Eq = std::equal_to<T>>
+    bool contains(const T &x, Eq eq = Eq()) const {
+        return find_index(x, eq) != VEC_NPOS;
+    }
+
+    template <typename Less = std::less<T>> void sort(Less less = Less()) {
+        std::sort(begin(), end(), less);
+    }
+
+    template <typename Less = std::less<T>>
+    void sort_reversed(Less less = Less()) {
+        std::sort(begin(), end(),
+                  [&](const T &a, const T &b) { return less(b, a); });
+    }
+
+    template <typename Less = std::less<T>>
+    void sort_stable(Less less = Less()) {
+        std::stable_sort(begin(), end(), less);
+    }
+};
+
+} // namespace vec
+
+#endif // VEC_HPP_DEFINED